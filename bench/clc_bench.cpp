@@ -0,0 +1,519 @@
+/// clc_bench : micro benchmarks of clc's hot paths
+///
+/// usage : clc_bench [--filter <text>] [--min-time <ms>] [--repetitions <n>] [--json <file>]
+///
+/// every case runs in batches : the batch grows until one takes min-time , then `repetitions`
+/// batches of that size are timed and min / median / max ns per iteration get reported
+/// bench/compare.py old.json new.json shows what moved between two runs
+/// after the table every clock source gets a million back-to-back reads : p50 / p99 / max of the
+/// deltas and the smallest non-zero one , the resolution a batch average can't show
+///
+/// the gl cases run in an offscreen egl context (mesa's surfaceless platform needs no display)
+/// and draw into a framebuffer object , they're skipped when no context can be made
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../include/clc_clock.h"
+#include "../include/clc_format.h"
+#include "../include/clc_gl.h"
+#include "../include/clc_history.h"
+#include "../include/clc_pacing.h"
+#include "../include/clc_persist.h"
+#include "../include/clc_shapes.h"
+#include "../include/clc_stopwatch.h"
+#include "../include/clc_text.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    /// keeps the compiler from dropping work whose result nobody reads
+    template <typename T>
+    inline void keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct bench_case
+    {
+        std::string name;
+        std::function<void(uint64_t iterations)> run;
+    };
+
+    struct bench_result
+    {
+        std::string name;
+        uint64_t iterations = 0;
+        double min_ns = 0 , median_ns = 0 , max_ns = 0;
+    };
+
+    bench_result measure(const bench_case &item , int64_t min_time_ns , int repetitions)
+    {
+        /// first calls pay for page faults and lazy shader compiles , keep them out of the sizing
+        item.run(1);
+        uint64_t iterations = 1;
+        while(true)
+        {
+            int64_t start = pacing_now_ns();
+            item.run(iterations);
+            int64_t took = pacing_now_ns() - start;
+            if(took >= min_time_ns || iterations >= (uint64_t(1) << 40))
+            {
+                break;
+            }
+            /// aim a bit past min-time so the next try is usually the last
+            uint64_t grow = took <= 0 ? 100 : uint64_t(double(min_time_ns) * 1.4 / double(took));
+            iterations *= std::clamp<uint64_t>(grow, 2, 100);
+        }
+
+        std::vector<double> per_iteration;
+        for (int i = 0; i < repetitions; i++)
+        {
+            int64_t start = pacing_now_ns();
+            item.run(iterations);
+            per_iteration.push_back(double(pacing_now_ns() - start) / double(iterations));
+        }
+        std::sort(per_iteration.begin(), per_iteration.end());
+
+        bench_result result;
+        result.name = item.name;
+        result.iterations = iterations;
+        result.min_ns = per_iteration.front();
+        result.median_ns = per_iteration[per_iteration.size() / 2];
+        result.max_ns = per_iteration.back();
+        return result;
+    }
+
+    /// back-to-back reads of one clock source : what a single read costs and how fine the steps are ,
+    /// which batch averages hide (coarse is a cheap read that only moves once a tick)
+    struct clock_jitter
+    {
+        std::string name;
+        uint64_t reads = 0;
+        double zero_percent = 0;   /// deltas of 0 , two reads that saw the same value
+        int64_t p50_ns = 0 , p99_ns = 0 , max_ns = 0;
+        int64_t min_step_ns = 0;   /// smallest non-zero delta , the visible resolution
+    };
+
+    clock_jitter measure_jitter(const std::string &name , int64_t (*read)() , uint64_t reads)
+    {
+        std::vector<int64_t> deltas(reads);
+        int64_t previous = read();
+        for (uint64_t i = 0; i < reads; i++)
+        {
+            int64_t now = read();
+            deltas[i] = now - previous;
+            previous = now;
+        }
+        std::sort(deltas.begin(), deltas.end());
+
+        clock_jitter result;
+        result.name = name;
+        result.reads = reads;
+        auto first_step = std::upper_bound(deltas.begin(), deltas.end(), int64_t(0));
+        result.zero_percent = 100.0 * double(first_step - deltas.begin()) / double(reads);
+        result.min_step_ns = first_step != deltas.end() ? *first_step : 0;
+        result.p50_ns = deltas[reads / 2];
+        result.p99_ns = deltas[reads * 99 / 100];
+        result.max_ns = deltas.back();
+        return result;
+    }
+
+    /// offscreen gl 3.3 core , rendering into an 800x600 fbo like clc's window
+    struct offscreen_gl
+    {
+        EGLDisplay display = EGL_NO_DISPLAY;
+        EGLContext context = EGL_NO_CONTEXT;
+        GLuint fbo = 0 , target = 0;
+
+        bool open()
+        {
+            auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            display = get_platform_display != nullptr ? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+            if(display == EGL_NO_DISPLAY)
+            {
+                display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            }
+            EGLint major , minor;
+            if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+            {
+                return false;
+            }
+            const EGLint config_attribs[] {EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+            EGLConfig config = nullptr;
+            EGLint configs = 0;
+            eglChooseConfig(display, config_attribs, &config, 1, &configs);
+            const EGLint context_attribs[] {
+                EGL_CONTEXT_MAJOR_VERSION, 3,
+                EGL_CONTEXT_MINOR_VERSION, 3,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE,
+            };
+            context = eglCreateContext(display, configs != 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+            if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) || !clc_gl_load())
+            {
+                return false;
+            }
+            glGenTextures(1, &target);
+            glBindTexture(GL_TEXTURE_2D, target);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 800, 600, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            clc_gl.GenFramebuffers(1, &fbo);
+            bind();
+            glViewport(0, 0, 800, 600);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            return clc_gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+
+        /// text_layer::create leaves framebuffer 0 bound , which doesn't exist without a surface
+        void bind()
+        {
+            clc_gl.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+            clc_gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+        }
+
+        ~offscreen_gl()
+        {
+            if(context != EGL_NO_CONTEXT)
+            {
+                eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                eglDestroyContext(display, context);
+            }
+            if(display != EGL_NO_DISPLAY)
+            {
+                eglTerminate(display);
+            }
+        }
+    };
+
+    /// no font here : every character becomes a solid box so the atlas has ink to measure
+    /// and the quads are as many as with real glyphs
+    int atlas_height = 0;
+    void draw_box(void * , const char *text , float x , float y)
+    {
+        const int width = int(135.0f * 0.6f * float(std::strlen(text)));
+        const int height = int(135.0f * 0.7f);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(int(x), atlas_height - int(y), width, height);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    void write_json(const char *path , const std::vector<bench_result> &results , const std::vector<clock_jitter> &jitters , int64_t min_time_ns , int repetitions , const char *gl_renderer)
+    {
+        FILE *out = std::fopen(path, "w");
+        if(out == nullptr)
+        {
+            printf("clc_bench : can't write %s\n", path);
+            return;
+        }
+        char host[64] {};
+        gethostname(host, sizeof(host) - 1);
+        char date[32];
+        time_t now = time(nullptr);
+        tm parts;
+        gmtime_r(&now, &parts);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &parts);
+
+        /// names and strings here never need escaping (no quotes or backslashes in them)
+        std::fprintf(out, "{\n  \"context\": {\n");
+        std::fprintf(out, "    \"date\": \"%s\",\n    \"host\": \"%s\",\n    \"compiler\": \"%s\",\n", date, host, __VERSION__);
+        std::fprintf(out, "    \"gl_renderer\": \"%s\",\n    \"min_time_ms\": %.1f,\n    \"repetitions\": %d\n  },\n", gl_renderer, double(min_time_ns) / 1e6, repetitions);
+        std::fprintf(out, "  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const bench_result &result = results[i];
+            std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %" PRIu64 ", \"min_ns\": %.3f, \"median_ns\": %.3f, \"max_ns\": %.3f}%s\n",
+                result.name.c_str(), result.iterations, result.min_ns, result.median_ns, result.max_ns, i + 1 == results.size() ? "" : ",");
+        }
+        std::fprintf(out, "  ],\n  \"clock_jitter\": [\n");
+        for (size_t i = 0; i < jitters.size(); i++)
+        {
+            const clock_jitter &jitter = jitters[i];
+            std::fprintf(out, "    {\"name\": \"%s\", \"reads\": %" PRIu64 ", \"zero_percent\": %.3f, \"p50_ns\": %" PRId64 ", \"p99_ns\": %" PRId64 ", \"max_ns\": %" PRId64 ", \"min_step_ns\": %" PRId64 "}%s\n",
+                         jitter.name.c_str(), jitter.reads, jitter.zero_percent, jitter.p50_ns, jitter.p99_ns, jitter.max_ns, jitter.min_step_ns, i + 1 < jitters.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+        std::fclose(out);
+    }
+}
+
+int main(int argc , char **argv)
+{
+    const char *filter = nullptr;
+    const char *json_path = nullptr;
+    int64_t min_time_ns = 100000000;
+    int repetitions = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            min_time_ns = std::max<int64_t>(int64_t(std::strtod(argv[++i], nullptr) * 1e6), 1000000);
+        }
+        else if(std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+        {
+            repetitions = std::max(std::atoi(argv[++i]), 1);
+        }
+        else
+        {
+            printf("usage : %s [--filter <text>] [--min-time <ms>] [--repetitions <n>] [--json <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<bench_case> cases;
+    std::mt19937_64 random(7);
+
+    /// format : the string under the big digits , redone every time it changes
+    std::vector<int64_t> times(1024);
+    for (int64_t &time : times)
+    {
+        time = int64_t(random() % 360000000000000ull);
+    }
+    cases.push_back({"format/t_str_fucn", [&](uint64_t iterations) {
+        t_str_buf buf;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            keep(t_str_fucn(times[i & 1023], buf));
+            keep(buf);
+        }
+    }});
+    cases.push_back({"format/next_redraw_ms", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            keep(next_redraw_ms(times[i & 1023]));
+        }
+    }});
+
+    /// clock : one read of every source clc can run on , and its read to read deltas below the table
+    std::vector<std::pair<std::string, int64_t (*)()>> jitter_sources;
+    const std::pair<const char *, clock_source> sources[] {
+        {"clock/steady", clock_source::steady},
+        {"clock/raw", clock_source::monotonic_raw},
+        {"clock/coarse", clock_source::monotonic_coarse},
+        {"clock/tsc", clock_source::tsc},
+    };
+    for (const auto &[name , source] : sources)
+    {
+        if(!select_clock_source(source))
+        {
+            printf("clc_bench : %s isn't usable here , skipped\n", name);
+            continue;
+        }
+        /// selecting tsc calibrates it (~20ms) , so each case keeps the reader it got here
+        int64_t (*read)() = clock_now_fn;
+        jitter_sources.push_back({std::string(name) + "/jitter", read});
+        cases.push_back({name, [read](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                keep(read());
+            }
+        }});
+    }
+    select_clock_source(clock_source::steady);
+    cases.push_back({"clock/suspended", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            keep(clock_suspended_ns());
+        }
+    }});
+    cases.push_back({"clock/elapsed_all_64", [](uint64_t iterations) {
+        stopwatch_set timers;
+        while(timers.size() < stopwatch_set::max_timers)
+        {
+            timers.add("t");
+        }
+        int64_t out[stopwatch_set::max_timers];
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            timers.elapsed_all(clc_clock::now(), out);
+            keep(out);
+        }
+    }});
+
+    /// persist : lt the way save_time and load_time go through it
+    char temp_template[] {"/tmp/clc_bench.XXXXXX"};
+    const char *temp_dir = mkdtemp(temp_template);
+    if(temp_dir == nullptr)
+    {
+        printf("clc_bench : no temp dir\n");
+        return 1;
+    }
+    const fs::path lt_path = fs::path(temp_dir) / "lt";
+    cases.push_back({"persist/encode_saved_time", [&](uint64_t iterations) {
+        char buf[64];
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            keep(encode_saved_time(times[i & 1023], buf, sizeof(buf)));
+            keep(buf);
+        }
+    }});
+    cases.push_back({"persist/lt_round_trip", [&](uint64_t iterations) {
+        char buf[64];
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            size_t len = encode_saved_time(times[i & 1023], buf, sizeof(buf));
+            write_file_atomic(lt_path, buf, len, false);
+            duration_ns loaded {0};
+            load_saved_time(lt_path, loaded);
+            keep(loaded);
+        }
+    }});
+    cases.push_back({"persist/checkpointer_flush", [&](uint64_t iterations) {
+        checkpointer saver;
+        saver.start(lt_path, 3600000000000, false);
+        stopwatch state;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            state.saved = duration_ns(times[i & 1023]);
+            saver.publish(0, state, journal_event::checkpoint, "main");
+            keep(saver.flush());
+        }
+        saver.stop();
+    }});
+
+    /// history : clc --report over five years of four runs a day
+    std::vector<session_record> records;
+    const int64_t day_ns = 86400000000000;
+    int64_t first_wall_ns = (int64_t(time(nullptr)) - 5 * 365 * 86400) * 1000000000;
+    for (int64_t day = 0; day < 5 * 365; day++)
+    {
+        for (int64_t run = 0; run < 4; run++)
+        {
+            int64_t end = first_wall_ns + day * day_ns + (run + 1) * 3 * 3600000000000;
+            records.push_back(make_session_record(0, end - 3600000000000, end, 3600000000000));
+        }
+    }
+    std::vector<session_day> days;
+    index_sessions(records.data(), records.size(), days);
+    cases.push_back({"history/sum_days_5y", [&](uint64_t iterations) {
+        int32_t first_day = days.front().day;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            int32_t from = first_day + int32_t(times[i & 1023] % 1800);
+            keep(sum_days(days.data(), days.size(), day_range {from, from + 30}).total_ns);
+        }
+    }});
+
+    /// shapes : what add_circle builds , the dot in clc's window is one of these
+    cases.push_back({"shapes/circle_vertices_64", [](uint64_t iterations) {
+        std::vector<float> out;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            out.clear();
+            shape_layer::ring_vertices(out, 200.0f, 200.0f, 9.0f, 11.0f, 64, 0.0f, 6.2831853f);
+            keep(out.data());
+        }
+    }});
+
+    /// gl : a frame's worth of text and shape submission , finished once per batch
+    offscreen_gl gl;
+    text_layer text;
+    shape_layer shapes;
+    const char *gl_renderer = "none";
+    const bool gl_ready = gl.open();
+    if(gl_ready)
+    {
+        gl_renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+        int atlas_width;
+        text_layer::atlas_size_for(135.0f, 1, atlas_width, atlas_height);
+        bool text_ok = text.create(135.0f, 800, 600, {"clc."}, draw_box, nullptr);
+        bool shapes_ok = shapes.create(800, 600);
+        gl.bind();
+        if(text_ok)
+        {
+            text.place_static(0, 10, 100);
+            cases.push_back({"gl/text_frame", [&](uint64_t iterations) {
+                t_str_buf buf;
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    size_t len = t_str_fucn(times[i & 1023], buf);
+                    text.set_dynamic(0, buf.data(), len, 170.0f, 350.0f);
+                    text.draw(1.0f, 1.0f, 1.0f, 1.0f);
+                }
+                glFinish();
+            }});
+        }
+        if(shapes_ok)
+        {
+            shape_layer::shape_id circle = shapes.add_circle(200, 200, 10, 64);
+            cases.push_back({"gl/circle_draw", [&shapes , circle](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    shapes.draw(circle, 1.0f, 1.0f, 1.0f, 1.0f);
+                }
+                glFinish();
+            }});
+        }
+    }
+    else
+    {
+        printf("clc_bench : no offscreen gl context , gl cases skipped\n");
+    }
+
+    std::vector<bench_result> results;
+    printf("%-28s %14s %12s %12s %12s\n", "case", "iterations", "min ns", "median ns", "max ns");
+    for (const bench_case &item : cases)
+    {
+        if(filter != nullptr && item.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        bench_result result = measure(item, min_time_ns, repetitions);
+        printf("%-28s %14" PRIu64 " %12.2f %12.2f %12.2f\n", result.name.c_str(), result.iterations, result.min_ns, result.median_ns, result.max_ns);
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    std::vector<clock_jitter> jitters;
+    for (const auto &[name , read] : jitter_sources)
+    {
+        if(filter != nullptr && name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        if(jitters.empty())
+        {
+            printf("\n%-28s %10s %10s %10s %12s %14s\n", "clock read to read", "same %", "p50 ns", "p99 ns", "max ns", "min step ns");
+        }
+        jitters.push_back(measure_jitter(name, read, 1000000));
+        const clock_jitter &jitter = jitters.back();
+        printf("%-28s %10.1f %10" PRId64 " %10" PRId64 " %12" PRId64 " %14" PRId64 "\n", jitter.name.c_str(), jitter.zero_percent, jitter.p50_ns, jitter.p99_ns, jitter.max_ns, jitter.min_step_ns);
+    }
+    if(json_path != nullptr)
+    {
+        write_json(json_path, results, jitters, min_time_ns, repetitions, gl_renderer);
+    }
+
+    if(gl_ready)
+    {
+        text.destroy();
+        shapes.destroy();
+    }
+    std::error_code ignored;
+    fs::remove_all(temp_dir, ignored);
+    return 0;
+}
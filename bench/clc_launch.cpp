@@ -0,0 +1,27 @@
+/// clc_launch : stamps CLOCK_MONOTONIC into CLC_EXEC_NS and execs the rest of the command line
+///
+/// usage : clc_launch <program> [args]
+///
+/// bench/startup.sh runs clc through this , so --startup-times measures exec -> main from a ns
+/// timestamp taken right before execv instead of /proc/self/stat's 1/CLK_TCK start time
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+int main(int argc , char **argv)
+{
+    if(argc < 2)
+    {
+        printf("usage : clc_launch <program> [args]\n");
+        return 1;
+    }
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    char stamp[32];
+    snprintf(stamp, sizeof(stamp), "%lld", (long long)now.tv_sec * 1000000000 + now.tv_nsec);
+    setenv("CLC_EXEC_NS", stamp, 1);
+    execvp(argv[1], argv + 1);
+    printf("clc_launch : can't exec %s\n", argv[1]);
+    return 127;
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# compares two clc_bench --json files case by case (median ns per iteration)
+# usage : bench/compare.py old.json new.json [--threshold <percent>]
+# exits 1 when a case got slower by more than threshold (default 10) , so ci can gate on it
+# cases only one side has are listed but never fail the run
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        data = json.load(file)
+    return data.get("context", {}), {case["name"]: case for case in data["benchmarks"]}
+
+
+def main(argv):
+    threshold = 10.0
+    paths = []
+    i = 1
+    while i < len(argv):
+        if argv[i] == "--threshold" and i + 1 < len(argv):
+            threshold = float(argv[i + 1])
+            i += 2
+            continue
+        paths.append(argv[i])
+        i += 1
+    if len(paths) != 2:
+        print("usage : compare.py old.json new.json [--threshold <percent>]")
+        return 2
+
+    old_context, old_cases = load(paths[0])
+    new_context, new_cases = load(paths[1])
+    for key in ("host", "compiler", "gl_renderer"):
+        if old_context.get(key) != new_context.get(key):
+            print(f"clc. bench : {key} differs ({old_context.get(key)} -> {new_context.get(key)}) , numbers may not compare")
+
+    print(f"{'case':28} {'old ns':>12} {'new ns':>12} {'change':>9}")
+    slower = []
+    for name in list(old_cases) + [name for name in new_cases if name not in old_cases]:
+        old = old_cases.get(name)
+        new = new_cases.get(name)
+        if old is None or new is None:
+            side = "new" if old is None else "gone"
+            value = (new or old)["median_ns"]
+            print(f"{name:28} {'-' if old is None else f'{value:12.2f}':>12} {'-' if new is None else f'{value:12.2f}':>12} {side:>9}")
+            continue
+        change = (new["median_ns"] - old["median_ns"]) / old["median_ns"] * 100.0 if old["median_ns"] > 0 else 0.0
+        mark = ""
+        # the new min above the old max too , so one noisy run alone doesn't fail it
+        if change > threshold and new["min_ns"] > old["max_ns"]:
+            mark = "  slower"
+            slower.append(name)
+        elif change < -threshold:
+            mark = "  faster"
+        print(f"{name:28} {old['median_ns']:12.2f} {new['median_ns']:12.2f} {change:+8.1f}%{mark}")
+
+    if slower:
+        print(f"clc. bench : {len(slower)} case(s) slower by more than {threshold:g}% : {' , '.join(slower)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# startup latency of clc : exec -> first swap , as printed by --startup-times
+# usage : bench/startup.sh <path to clc> [runs] [path to clc_launch]
+# uses xvfb-run when it is installed , otherwise the current $DISPLAY
+# HOME points to a temp dir so ~/.clc is never touched , run 1 is a cold atlas cache
+# clc_launch (next to clc by default) execs clc with its CLOCK_MONOTONIC time in CLC_EXEC_NS ,
+# inside xvfb-run so the x server start isn't counted . without it clc falls back to
+# /proc/self/stat , which only has 10 ms steps
+
+clc="$1"
+runs="${2:-50}"
+clc_launch="${3:-$(dirname "$clc")/clc_launch}"
+if [ -z "$clc" ] || [ ! -x "$clc" ]; then
+    echo "usage : $0 <path to clc> [runs] [path to clc_launch]"
+    exit 1
+fi
+stamp=("$clc_launch")
+if [ ! -x "$clc_launch" ]; then
+    echo "clc. bench : no clc_launch , exec -> main only has /proc/self/stat resolution"
+    stamp=()
+fi
+
+bench_home=$(mktemp -d)
+trap 'rm -rf "$bench_home"' EXIT
+
+launcher=()
+if command -v xvfb-run > /dev/null; then
+    launcher=(xvfb-run -a -s "-screen 0 1024x768x24")
+elif [ -z "$DISPLAY" ]; then
+    echo "clc. bench : no xvfb-run and no DISPLAY , can't open a window"
+    exit 1
+fi
+
+totals=()
+for ((i = 1; i <= runs; i++)); do
+    total=$(HOME="$bench_home" "${launcher[@]}" "${stamp[@]}" "$clc" --startup-times --exit-after-first-frame 2> /dev/null \
+        | awk '/clc. startup : first swap/ { gsub(/[()]/, ""); print $(NF - 1) }')
+    if [ -z "$total" ]; then
+        echo "clc. bench : run $i didn't reach the first frame"
+        exit 1
+    fi
+    if [ "$i" -eq 1 ]; then
+        echo "cold start (no atlas cache) : $total ms"
+    fi
+    totals+=("$total")
+done
+
+printf '%s\n' "${totals[@]}" | sort -n | awk -v runs="$runs" '
+    { value[NR] = $1 }
+    END {
+        p50 = value[int((NR - 1) * 0.50) + 1]
+        p99 = value[int((NR - 1) * 0.99) + 1]
+        printf "clc. bench : %d runs , exec -> first swap  p50 %.3f ms  p99 %.3f ms  max %.3f ms\n", runs, p50, p99, value[NR]
+    }'
@@ -1,6 +1,10 @@
 /// no need for pragma once :>
 // 
+#include <array>
+#include <charconv>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -11,6 +15,10 @@
 #include <sys/types.h>
 #include <string>
 #include <printf.h>
+#include <atomic>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #define GLYPH_MINIMAL
 #define RGFW_DEBUG
@@ -22,42 +30,21 @@ extern "C"
 #include "./glyph/glyph.h"
 };
 #include <GL/gl.h>
-
-/// this easy to use function just writed by IshaqKassam
-/// so i define it here for now(2025:dec:6)
-
-inline void drawCircle(float cx, float cy, float r, int num_segments)
-{
-    float theta = 3.1415926 * 2 / float(num_segments);
-    float tangetial_factor = tanf(theta);//calculate the tangential factor 
-
-    float radial_factor = cosf(theta);//calculate the radial factor 
-
-    float x = r;//we start at angle = 0 
-
-    float y = 0;
-    glLineWidth(2);
-    glBegin(GL_LINE_LOOP);
-    for (int ii = 0; ii < num_segments; ii++)
-    {
-        glVertex2f(x + cx, y + cy);//output vertex 
-
-        //calculate the tangential vector 
-        //remember, the radial vector is (x, y) 
-        //to get the tangential vector we flip those coordinates and negate one of them 
-
-        float tx = -y;
-        float ty = x;
-
-        //add the tangential vector 
-
-        x += tx * tangetial_factor;
-        y += ty * tangetial_factor;
-
-        //correct using the radial factor 
-
-        x *= radial_factor;
-        y *= radial_factor;
-    }
-    glEnd();
-}
+#include <X11/keysym.h>
+
+#include "clc_control.h"
+#include "clc_format.h"
+#include "clc_history.h"
+#include "clc_input.h"
+#include "clc_journal.h"
+#include "clc_laps.h"
+#include "clc_latch.h"
+#include "clc_pacing.h"
+#include "clc_persist.h"
+#include "clc_profile.h"
+#include "clc_shapes.h"
+#include "clc_shm.h"
+#include "clc_startup.h"
+#include "clc_stopwatch.h"
+#include "clc_text.h"
+#include "clc_tty.h"
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "clc_stopwatch.h"
+
+/// "90" , "90s" , "5m" , "1.5h" : a countdown length , false for anything else or not above zero
+bool parse_countdown(const char *text , duration_ns &out);
+
+/// countdown timers (stopwatch::target) stop themselves at zero with no loop watching the clock
+///
+/// one timerfd holds the earliest deadline of every running countdown as an absolute time on
+/// CLOCK_MONOTONIC (CLOCK_BOOTTIME under --suspend count , the clock clc reads then) and turns
+/// readable when it's due , so a paused window asleep in its event wait still fires on time .
+/// the tty polls fd() next to stdin . rgfw's wait can't take an fd , so for the window a small
+/// thread sleeps on it and wakes the window the way clc --control does
+struct alarm_timer
+{
+    /// called from the alarm thread when a deadline passed , the frontend should call take_due
+    using wake_fn = void (*)(void *ctx);
+
+    /// after the clock and the suspend policy are picked
+    /// wake null : no thread , the caller polls fd() and calls take_due when it's readable
+    bool open(wake_fn wake = nullptr , void *ctx = nullptr);
+    void close();
+
+    int fd() const { return timer_fd; }
+
+    /// with the timers lock held , after anything that can change a countdown (keys , control
+    /// commands , expire) . points the timerfd at the earliest deadline or disarms it , it's
+    /// only a syscall when that moved
+    void arm(const stopwatch_set &timers);
+
+    /// true once per firing
+    bool take_due();
+
+    /// with the timers lock held : stops every countdown whose deadline passed , each exactly at
+    /// its deadline so it reads zero , their indexes go to out (max_timers slots) , returns how many
+    size_t expire(stopwatch_set &timers , clc_clock::time_point now , size_t *out);
+
+    ~alarm_timer() { close(); }
+
+private:
+    void run();
+
+    int timer_fd = -1;
+    int stop_fd = -1;
+    int timer_clock = 0;
+    int64_t armed_ns = 0; /// clc clock deadline the timerfd is set to , 0 when disarmed
+    std::atomic<bool> due {false};
+    wake_fn wake = nullptr;
+    void *wake_ctx = nullptr;
+    std::thread waiter;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+/// where clc reads "now" from , picked once at startup (--clock <name>)
+/// every source is monotonic , but they don't share a zero so don't switch while a timer runs
+enum class clock_source
+{
+    steady,           /// std::chrono::steady_clock (CLOCK_MONOTONIC on linux)
+    monotonic_raw,    /// CLOCK_MONOTONIC_RAW , not slewed by ntp
+    monotonic_coarse, /// CLOCK_MONOTONIC_COARSE , cheapest syscall-free read but only tick resolution
+    tsc,              /// rdtsc scaled by a startup calibration , x86 with invariant tsc only
+};
+
+/// what happens to a running timer while the machine is suspended (--suspend <name>)
+/// CLOCK_MONOTONIC stops during suspend , CLOCK_BOOTTIME keeps going
+enum class suspend_policy
+{
+    skip,  /// the default , time asleep isn't counted (every clock_source is monotonic)
+    count, /// time asleep is counted , clc reads CLOCK_BOOTTIME (steady source only)
+};
+
+extern int64_t (*clock_now_fn)();
+extern int64_t (*clock_suspended_fn)();
+
+/// current time of the selected source in nanoseconds
+inline int64_t clock_now_ns()
+{
+    return clock_now_fn();
+}
+
+/// CLOCK_BOOTTIME - CLOCK_MONOTONIC : how long the machine has been suspended since boot
+/// whatever the policy , stopwatch stamps it next to every start so a run knows how much of it
+/// was spent asleep (a few dozen ns of jitter , the two reads aren't atomic)
+inline int64_t clock_suspended_ns()
+{
+    return clock_suspended_fn();
+}
+
+const char *clock_source_name(clock_source source);
+bool clock_source_from_name(const char *name, clock_source &out);
+
+/// switch the source , tsc gets calibrated here (~20ms)
+/// returns false and keeps steady when the source can't be used on this machine
+bool select_clock_source(clock_source source);
+clock_source current_clock_source();
+
+const char *suspend_policy_name(suspend_policy policy);
+bool suspend_policy_from_name(const char *name, suspend_policy &out);
+/// returns false and keeps skip for count with a source other than steady
+/// (raw , coarse and tsc have no variant that runs through suspend)
+bool select_suspend_policy(suspend_policy policy);
+suspend_policy current_suspend_policy();
+
+/// true when clock_now_ns() is plain CLOCK_MONOTONIC (steady source , skip , no fake)
+bool clock_is_monotonic();
+
+/// stands in for the kernel clocks so tests and benches can move time by hand
+/// monotonic stops while suspended and boottime doesn't , like the real ones
+struct fake_clock
+{
+    int64_t monotonic_ns = 0;
+    int64_t boottime_ns = 0;
+
+    void advance(int64_t ns)
+    {
+        monotonic_ns += ns;
+        boottime_ns += ns;
+    }
+
+    void suspend(int64_t ns)
+    {
+        boottime_ns += ns;
+    }
+};
+
+/// every clc clock read goes to `clock` (through the suspend policy) until it's uninstalled
+/// not thread safe , install it before anything else reads the clock
+void clock_install_fake(const fake_clock *clock);
+void clock_uninstall_fake();
+
+/// std::chrono clock on top of the selected source so stopwatch can keep using time_point
+struct clc_clock
+{
+    using rep = int64_t;
+    using period = std::nano;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<clc_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+        return time_point(duration(clock_now_ns()));
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "clc_alarm.h"
+#include "clc_laps.h"
+#include "clc_persist.h"
+#include "clc_stopwatch.h"
+
+/// clc --control : scripts and ci drive the timers through ~/.clc/control (AF_UNIX stream)
+///
+/// line protocol , one command per line and exactly one reply line per command in order ,
+/// so a client can pipeline as many commands as it wants before reading
+///   start [i] , stop [i] , toggle [i] , reset [i] , lap [i] , query [i]   i = stopwatch_set index ,
+///                                                                      the active timer if left out
+///   new [name] , countdown <length> [name] , count     length as in parse_countdown (90 , 5m , 1.5h) ,
+///                                                      a countdown is created stopped like new
+/// replies
+///   "ok <i> <running 0/1> <elapsed ns> <laps>"  for the timer commands
+///   "ok <n>"                                   for new and countdown (index of the new timer) and count
+///   "err <why>"
+inline std::filesystem::path control_socket_path()
+{
+    const char *home = getenv("HOME");
+    return std::filesystem::path(home != nullptr ? home : "") / ".clc" / "control";
+}
+
+/// one epoll thread for the listening socket and every client , sockets are all non-blocking
+/// commands run on that thread under `lock` , the same lock the frontend holds while it reads
+/// or changes the timers , so a reply never waits for a frame
+struct control_server
+{
+    /// called (without the lock) after commands changed something , the frontend should redraw
+    using wake_fn = void (*)(void *ctx);
+
+    /// fails if the socket can't be made or another clc already answers on it
+    bool start(const std::filesystem::path &path , stopwatch_set &timers , lap_ring &laps , checkpointer &saver , std::mutex &lock , wake_fn wake , void *ctx);
+    void stop();
+
+    ~control_server() { stop(); }
+
+private:
+    static constexpr size_t max_clients = 64;
+    static constexpr size_t max_line = 256;
+    /// replies a client hasn't read yet , past this its lines wait in `in` and the socket isn't
+    /// read until it drains , a pipelining client that never reads can't grow clc's memory
+    /// (`in` stops taking more at the same size)
+    static constexpr size_t max_pending_out = 64 * 1024;
+
+    struct client
+    {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        uint32_t events = 0; /// what epoll watches now
+        bool eof = false;    /// the peer stopped sending , close once everything is answered
+    };
+
+    void run();
+    void accept_clients();
+    /// read_client : false on error , eof sets c.eof and the client stays open until its replies went out
+    /// write_client : false when the client is gone and got closed
+    bool read_client(client &c);
+    bool write_client(client &c);
+    void close_client(client &c);
+    /// EPOLLIN while c.out is under max_pending_out and no eof , EPOLLOUT while c.out isn't empty
+    void watch_client(client &c);
+    /// complete lines in c.in until c.out reaches max_pending_out , replies appended to c.out ,
+    /// true if any timer changed
+    bool execute_lines(client &c);
+    bool execute(const char *line , size_t len , std::string &reply);
+    void reply_timer(size_t index , std::string &reply);
+
+    std::filesystem::path socket_path;
+    stopwatch_set *timers = nullptr;
+    lap_ring *laps = nullptr;
+    checkpointer *saver = nullptr;
+    std::mutex *state_lock = nullptr;
+    wake_fn wake = nullptr;
+    void *wake_ctx = nullptr;
+
+    std::array<client, max_clients> clients {}; /// fixed slots , the epoll tag is the slot index
+    std::thread worker;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int stop_fd = -1;
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// 8 visible chars + '\0' , t_str_fucn never writes more than this
+using t_str_buf = std::array<char, 9>;
+
+/// formats time_ns as [h.][m.]s.ffffff cut to 8 chars into out , returns the length
+/// no heap and no floating point here , it runs every frame
+size_t t_str_fucn (int64_t time_ns , t_str_buf &out);
+
+/// how many ms until the last digit t_str_fucn shows for `time_ns` changes
+/// worked out from the same layout , so past 10h ("12.34.56") that's the seconds , not a fraction
+/// counting_down : time_ns is what's left of a countdown , the digit changes when it drops below
+int next_redraw_ms(int64_t time_ns, bool counting_down = false);
+
+/// one row of the lap list : lap number right aligned in 4 , two spaces , the split
+/// "   7  1.250000" , a longer number widens the row instead of wrapping , 21 chars at most with the '\0'
+using lap_str_buf = std::array<char, 21>;
+size_t lap_str_fucn (uint32_t number , int64_t split_ns , lap_str_buf &out);
@@ -0,0 +1,55 @@
+#pragma once
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+/// gl 2.0+ entry points that clc's own renderers need
+/// glyph loads its own copy , these are kept apart so the two never clash
+#define CLC_GL_FUNCS(X)                                             \
+    X(PFNGLCREATESHADERPROC, CreateShader)                          \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource)                          \
+    X(PFNGLCOMPILESHADERPROC, CompileShader)                        \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv)                            \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog)                  \
+    X(PFNGLDELETESHADERPROC, DeleteShader)                          \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram)                        \
+    X(PFNGLATTACHSHADERPROC, AttachShader)                          \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram)                            \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv)                          \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog)                \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram)                        \
+    X(PFNGLUSEPROGRAMPROC, UseProgram)                              \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation)              \
+    X(PFNGLUNIFORM1IPROC, Uniform1i)                                \
+    X(PFNGLUNIFORM2FPROC, Uniform2f)                                \
+    X(PFNGLUNIFORM4FPROC, Uniform4f)                                \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays)                    \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray)                    \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays)              \
+    X(PFNGLGENBUFFERSPROC, GenBuffers)                              \
+    X(PFNGLBINDBUFFERPROC, BindBuffer)                              \
+    X(PFNGLBUFFERDATAPROC, BufferData)                              \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData)                        \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers)                        \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer)            \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray)    \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers)                    \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer)                    \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, FramebufferTexture2D)          \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus)      \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, DeleteFramebuffers)              \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture)
+
+struct clc_gl_api
+{
+#define CLC_GL_MEMBER(type, name) type name = nullptr;
+    CLC_GL_FUNCS(CLC_GL_MEMBER)
+#undef CLC_GL_MEMBER
+};
+
+extern clc_gl_api clc_gl;
+
+/// needs a current context , returns false if any entry point is missing
+bool clc_gl_load();
+
+/// compiles and links a vertex + fragment pair , 0 on failure (log goes to stdout)
+GLuint clc_gl_program(const char *vertex_src, const char *fragment_src);
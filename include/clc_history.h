@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/// ~/.clc/sessions : append-only , one 32 byte record per finished run of any timer
+/// ~/.clc/sessions.idx : one entry per local day that has time on it , sorted by day , each
+/// carrying the sum of every day before it . the time between two days is two binary searches
+/// and a subtraction , however many years the sessions file holds
+///
+/// a run over midnight counts toward both days . the index is only a cache of the sessions
+/// file : when its header doesn't match (a crash between the two writes) it gets rebuilt
+struct session_record
+{
+    int64_t start_wall_ns; /// CLOCK_REALTIME
+    int64_t end_wall_ns;
+    int64_t length_ns;     /// measured on the clc clock , wall time can jump meanwhile
+    uint16_t magic;
+    uint16_t timer;        /// stopwatch_set index
+    uint32_t check;        /// hash of the fields above , bad check = end of the file
+};
+static_assert(sizeof(session_record) == 32, "session records are fixed size on disk");
+
+struct session_day
+{
+    int32_t day;       /// days since 1970-01-01 on the local calendar
+    uint32_t sessions; /// runs that touch the day
+    int64_t day_ns;
+    int64_t before_ns; /// day_ns of every earlier entry summed
+};
+static_assert(sizeof(session_day) == 24, "index entries are fixed size on disk");
+
+constexpr uint16_t session_magic = 0xC1C5;
+constexpr const char session_index_magic[8] {"clcidx1"};
+
+struct session_index_header
+{
+    char magic[8];
+    uint64_t session_count; /// records of the sessions file this index covers
+    uint64_t day_count;     /// entries after the header
+    uint64_t reserved;
+};
+static_assert(sizeof(session_index_header) == 32, "index header is fixed size on disk");
+
+session_record make_session_record(size_t timer , int64_t start_wall_ns , int64_t end_wall_ns , int64_t length_ns);
+bool session_record_valid(const session_record &record);
+
+/// local calendar days , mktime/localtime_r so dst and the timezone are the system's
+int32_t local_day(int64_t wall_ns);
+int64_t local_day_start_ns(int32_t day);
+/// "2026-10-16" , returns the length
+size_t format_day(int32_t day , char *buf , size_t size);
+
+/// both ends included
+struct day_range
+{
+    int32_t first;
+    int32_t last;
+};
+
+/// today , yesterday , week (since monday) , month , year , all , <n>d (the last n days) ,
+/// yyyy-mm-dd , or <from>..<to> with a date or today on each side
+bool parse_day_range(const char *text , int32_t today , day_range &out);
+
+struct range_total
+{
+    int64_t total_ns = 0;
+    const session_day *begin = nullptr; /// the index entries inside the range
+    const session_day *end = nullptr;
+};
+
+/// binary searches a sorted index , no day entry is read besides the two ends
+range_total sum_days(const session_day *days , size_t count , day_range range);
+
+/// spreads every record over the days it touches and fills in before_ns
+void index_sessions(const session_record *records , size_t count , std::vector<session_day> &days);
+
+/// writer side , owned by the checkpointer's worker thread
+struct session_history
+{
+    /// opens (or creates) both files , rebuilds the index if it doesn't cover every record
+    bool open(const std::filesystem::path &sessions_path);
+    void close();
+
+    /// one write() for the records , then the index entries that changed and its header
+    bool append(const session_record *records , size_t count , bool sync);
+
+    bool is_open() const { return sessions_fd >= 0; }
+
+    ~session_history() { close(); }
+
+private:
+    bool write_index(size_t first_changed , bool sync);
+
+    std::filesystem::path index_path;
+    std::vector<session_day> days;
+    uint64_t session_count = 0;
+    int sessions_fd = -1;
+    int index_fd = -1;
+};
+
+/// clc --report <range> : one line per day (short ranges) and the total , returns the exit code
+int print_report(const std::filesystem::path &sessions_path , const char *range_text);
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// x server event times are 32 bit ms . xorg and xwayland read them from CLOCK_MONOTONIC , so an
+/// event's ms on our clock is how far it is behind now , wrapping every 49 days . a server on some
+/// other clock (a remote display) shows up as events seconds away from now and isn't trusted
+/// the event happened somewhere inside its ms , the middle of it is returned (± 0.5ms)
+bool server_ms_to_monotonic(uint32_t server_ms , int64_t now_ns , int64_t &out_ns);
+
+/// key press to the moment the loop handled it , 0.25ms buckets up to 32ms (the last one takes
+/// everything slower) . that is the error the start / stop edges had before server stamps
+struct input_latency
+{
+    static constexpr size_t bucket_count = 128;
+    static constexpr int64_t bucket_ns = 250000;
+
+    uint32_t buckets[bucket_count] {};
+    uint64_t stamped = 0;   /// presses with a server time
+    uint64_t unstamped = 0; /// presses stamped with when the loop got to them
+    int64_t max_ns = 0;
+
+    void record(int64_t latency_ns);
+    /// upper edge of the bucket that holds percentile p (0..1) , 0 with no presses
+    int64_t percentile_ns(double p) const;
+};
+
+void print_input_latency(const input_latency &stats);
+
+/// a second x connection listening to XI2 raw key presses . rgfw doesn't hand out the event time ,
+/// so a press it reports is matched here by keycode , oldest first
+/// only listens while the window has focus , raw events come whichever window is focused
+/// (src/clc_xinput.cpp , part of the clc executable since it needs libXi)
+struct key_stamper
+{
+    bool open();
+    void close();
+
+    /// the window got / lost focus , presses seen meanwhile are dropped
+    void set_focused(bool focused);
+
+    /// CLOCK_MONOTONIC ns of the oldest unmatched press of keysym , false when there is none
+    /// (a key repeat , or the server clock doesn't line up) . now_ns is CLOCK_MONOTONIC
+    bool take_press(unsigned long keysym , int64_t now_ns , int64_t &press_ns);
+
+    bool is_open() const { return display != nullptr; }
+
+    ~key_stamper() { close(); }
+
+private:
+    void drain();
+    void select(bool on);
+
+    struct press
+    {
+        uint32_t keycode;
+        uint32_t server_ms;
+    };
+    static constexpr size_t max_pending = 16;
+
+    void *display = nullptr;
+    int xi_opcode = 0;
+    press pending[max_pending] {};
+    size_t pending_count = 0;
+};
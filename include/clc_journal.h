@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/// ~/.clc/journal : append-only list of fixed 40 byte records , one per stopwatch event
+/// every record also carries the total right after the event , so the last valid record
+/// is the answer even if the tail got torn by a crash
+enum class journal_event : uint16_t
+{
+    start = 1,
+    stop = 2,
+    reset = 3,
+    checkpoint = 4, /// periodic save while running , bounds what a crash can lose
+    snapshot = 5,   /// first record after compaction , aux = runs folded into it
+    lap = 6,        /// lap key , aux = split since the previous lap (compaction drops them)
+};
+
+struct journal_record
+{
+    uint16_t magic;
+    uint16_t type;   /// journal_event in the low byte , stopwatch_set index in the high byte
+    uint32_t check;  /// hash of the fields below , bad check = end of journal
+    int64_t mono_ns; /// clc_clock at the event (snapshot : sum of finished runs)
+    int64_t wall_ns; /// CLOCK_REALTIME at the event
+    int64_t total_ns;
+    int64_t aux;     /// stop : length of the run it ended , snapshot : finished runs so far , lap : split
+};
+static_assert(sizeof(journal_record) == 40, "journal records are fixed size on disk");
+
+constexpr uint16_t journal_magic = 0xC1C0;
+
+journal_record make_journal_record(journal_event type , int64_t mono_ns , int64_t total_ns , int64_t aux = 0 , size_t timer = 0);
+bool journal_record_valid(const journal_record &record);
+
+inline journal_event journal_record_event(const journal_record &record)
+{
+    return journal_event(record.type & 0xff);
+}
+
+inline size_t journal_record_timer(const journal_record &record)
+{
+    return record.type >> 8;
+}
+
+struct journal_summary
+{
+    size_t records = 0;
+    size_t torn_bytes = 0;  /// garbage after the last valid record
+    int64_t total_ns = 0;   /// timer 0 , the one lt holds
+    int64_t runs = 0;       /// finished start..stop runs of every timer
+    int64_t run_ns = 0;     /// sum of those runs (resets don't clear it)
+    int64_t laps = 0;
+    bool running = false;   /// last event left timer 0 running (clc died while counting)
+    std::vector<int64_t> timer_totals;   /// by stopwatch_set index
+    std::vector<uint8_t> timer_running;
+    int64_t first_wall_ns = 0;
+    int64_t last_wall_ns = 0;
+};
+
+/// mmaps the file and walks it once , false if it doesn't exist
+bool journal_replay(const std::filesystem::path &path , journal_summary &out);
+
+struct journal
+{
+    /// replays what is there , compacts it if it's over compact_records , then opens for append
+    bool open(const std::filesystem::path &path , size_t compact_records , journal_summary &summary);
+    void close();
+
+    /// one write() for the whole batch
+    bool append(const journal_record *records , size_t count , bool sync);
+
+    /// rewrite the journal as a single snapshot record (atomic rename) , false leaves it as it was
+    bool compact();
+
+    size_t size() const { return record_count; }
+    bool is_open() const { return fd >= 0; }
+
+    ~journal() { close(); }
+
+private:
+    std::filesystem::path file_path;
+    size_t compact_limit = 0;
+    size_t record_count = 0;
+    int fd = -1;
+};
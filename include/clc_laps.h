@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "clc_stopwatch.h"
+
+struct lap_entry
+{
+    int64_t mono_ns = 0;   /// clc_clock when the lap key was hit
+    int64_t total_ns = 0;  /// timer elapsed at that moment
+    int64_t split_ns = 0;  /// since the previous lap of the same timer (or since zero)
+    uint32_t number = 0;   /// 1 based , counted per timer
+    uint8_t timer = 0;
+};
+
+/// laps of every timer in one preallocated ring , the oldest gets overwritten when it's full
+/// push is O(1) and never allocates , so splits can come as fast as the key repeats
+///
+/// `flushed` is how far the checkpointer has taken laps , everything after it is pending
+/// and goes out in batches (see checkpointer::publish_laps)
+struct lap_ring
+{
+    static constexpr size_t capacity = 4096;
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    /// a single lap waits at most this long before it goes to the checkpointer
+    static constexpr int64_t flush_after_ns = 250000000;
+
+    std::array<lap_entry, capacity> entries {};
+    uint64_t pushed = 0;    /// laps ever pushed , the next one goes to entries[pushed % capacity]
+    uint64_t flushed = 0;
+    uint64_t overwritten = 0; /// pending laps lost because the ring lapped them
+
+    std::array<int64_t, stopwatch_set::max_timers> last_total {};
+    std::array<uint32_t, stopwatch_set::max_timers> count {};
+    std::array<uint64_t, stopwatch_set::max_timers> since {}; /// first sequence after the last reset
+
+    const lap_entry &push(size_t timer , int64_t total_ns , int64_t mono_ns)
+    {
+        if(pushed - flushed == capacity)
+        {
+            flushed++;
+            overwritten++;
+        }
+        lap_entry &entry = entries[pushed & (capacity - 1)];
+        entry.mono_ns = mono_ns;
+        entry.total_ns = total_ns;
+        entry.split_ns = total_ns - last_total[timer];
+        entry.number = ++count[timer];
+        entry.timer = uint8_t(timer);
+        last_total[timer] = total_ns;
+        pushed++;
+        return entry;
+    }
+
+    /// after r the next split counts from zero again and the list starts empty
+    void reset_timer(size_t timer)
+    {
+        last_total[timer] = 0;
+        count[timer] = 0;
+        since[timer] = pushed;
+    }
+
+    size_t size() const
+    {
+        return pushed < capacity ? size_t(pushed) : capacity;
+    }
+
+    /// 0 is the newest lap , size() - 1 the oldest one still in the ring
+    const lap_entry &newest(size_t i) const
+    {
+        return entries[(pushed - 1 - i) & (capacity - 1)];
+    }
+
+    const lap_entry &at(uint64_t sequence) const
+    {
+        return entries[sequence & (capacity - 1)];
+    }
+
+    size_t pending() const
+    {
+        return size_t(pushed - flushed);
+    }
+
+    /// a full batch is worth sending now , a lone lap only once it got old
+    bool flush_due(int64_t now_ns , size_t batch) const
+    {
+        return pending() >= batch || (pending() != 0 && now_ns - at(flushed).mono_ns >= flush_after_ns);
+    }
+
+    /// the newest laps of one timer , skipping `skip` of them , returns how many landed in out
+    size_t newest_of(size_t timer , size_t skip , const lap_entry **out , size_t max) const
+    {
+        size_t found = 0;
+        for (size_t i = 0; i < size() && found < max && pushed - 1 - i >= since[timer]; i++)
+        {
+            const lap_entry &entry = newest(i);
+            if(entry.timer != timer)
+            {
+                continue;
+            }
+            if(skip != 0)
+            {
+                skip--;
+                continue;
+            }
+            out[found++] = &entry;
+        }
+        return found;
+    }
+};
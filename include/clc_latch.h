@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+/// when the big digits read the clock (--latch <name>)
+enum class latch_mode
+{
+    off,     /// with the rest of the frame state , before pacing sleeps and drawing (the old way)
+    late,    /// again right before the text is submitted , the default
+    predict, /// late , plus how long until that frame is expected on screen
+};
+
+const char *latch_mode_name(latch_mode mode);
+bool latch_mode_from_name(const char *name , latch_mode &out);
+
+/// guesses how long after the latch a frame becomes visible
+///
+/// with GLX_OML_sync_control it knows when the last vblank was and the refresh period , so the
+/// frame shows at the first vblank after the latch plus what submitting and swapping take .
+/// without it (or with swap interval 0) it's latch to swap return , averaged
+/// times are CLOCK_MONOTONIC (pacing_now_ns) , only the difference is used
+struct present_predictor
+{
+    /// needs the window's context current , false if there's no OML (averages only then)
+    bool init(int swap_interval);
+
+    /// ns from latch_ns until the frame latched then is expected on screen , no x round trip
+    int64_t lead_ns(int64_t latch_ns) const;
+
+    /// after every swap : when the frame latched , when the swap was called and when it returned
+    /// (with OML this also asks the server for the last vblank , once a frame and off the latch path)
+    void frame_swapped(int64_t latch_ns , int64_t swap_call_ns , int64_t swap_done_ns);
+
+    bool has_sync_control() const { return get_sync_values != nullptr; }
+
+private:
+    void *get_sync_values = nullptr; /// glXGetSyncValuesOML
+    void *display = nullptr;
+    unsigned long drawable = 0;
+    bool vsync = true;
+    int64_t refresh_ns = 0;
+    int64_t vblank_ns = 0;   /// last vblank the server told about
+    int64_t submit_ns = 0;   /// latch to swap call , averaged
+    int64_t swap_ns = 0;     /// latch to swap return , averaged
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// how the window decides when to draw (--pacing <name> , --fps <n> implies fixed)
+enum class pacing_mode
+{
+    vsync,    /// (default) swap interval 1 , draws when the digits change , paused it blocks until an event
+    fixed,    /// swap interval 0 , one frame per 1/fps on absolute clock_nanosleep deadlines
+    adaptive, /// vsync while a timer runs , one frame per second while paused
+};
+
+const char *pacing_mode_name(pacing_mode mode);
+bool pacing_mode_from_name(const char *name , pacing_mode &out);
+
+/// CLOCK_MONOTONIC ns , what the deadlines and the frame histogram use whatever --clock is
+int64_t pacing_now_ns();
+
+struct frame_pacer
+{
+    pacing_mode mode = pacing_mode::vsync;
+    int64_t period_ns = 16666667;   /// fixed only
+    int64_t deadline_ns = 0;        /// fixed only , next frame
+    int64_t last_frame_ns = 0;
+
+    static constexpr int64_t paused_period_ns = 1000000000;
+
+    void begin(pacing_mode new_mode , double fps);
+
+    int swap_interval() const { return mode == pacing_mode::fixed ? 0 : 1; }
+
+    /// how long the event wait may block (ms , -1 = until an event)
+    /// content_ms is when the shown digits change next (-1 = never) , want_frame says a
+    /// frame is owed already (event , control command)
+    int wait_ms(int content_ms , bool want_frame , int64_t now_ns) const;
+
+    /// adaptive while paused : true once a second , the caller draws a frame for it
+    bool tick_due(bool running , int64_t now_ns) const;
+
+    /// fixed : false while the deadline is more than a ms away , keep waiting for events then
+    bool ready(int64_t now_ns) const;
+
+    /// fixed : sleeps to the deadline (absolute , no drift) and moves it one period on
+    /// a frame that missed its deadline by more than a period starts a new grid from now
+    void wait_for_deadline();
+
+    /// after the swap
+    void frame_done(int64_t now_ns) { last_frame_ns = now_ns; }
+};
+
+/// swap to swap intervals in 0.5ms buckets (0..32ms , the last one takes everything slower)
+struct frame_histogram
+{
+    static constexpr size_t bucket_count = 64;
+    static constexpr int64_t bucket_ns = 500000;
+
+    uint32_t buckets[bucket_count] {};
+    uint64_t frames = 0;
+    int64_t last_swap_ns = 0;
+
+    /// intervals over a second are a paused window , not a frame time , they're skipped
+    void record(int64_t swap_ns);
+    /// upper edge of the bucket that holds percentile p (0..1) , 0 with no frames
+    int64_t percentile_ns(double p) const;
+    uint32_t max_bucket() const;
+    void clear();
+};
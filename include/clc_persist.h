@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clc_history.h"
+#include "clc_journal.h"
+#include "clc_laps.h"
+#include "clc_shm.h"
+#include "clc_spsc.h"
+#include "clc_stopwatch.h"
+
+/// ~/.clc/lt is "clc1 <nanoseconds>" , old files only had double seconds
+constexpr const char saved_time_magic[] {"clc1"};
+
+/// writes path.tmp then renames it over path , so readers and crashes only ever see
+/// the old or the new file . with sync the data (and the rename) hit the disk before returning
+bool write_file_atomic(const std::filesystem::path &path , const char *data , size_t len , bool sync);
+
+/// "clc1 <ns>\n" into buf , returns the length
+size_t encode_saved_time(int64_t total_ns , char *buf , size_t size);
+
+/// reads lt in either format , false (and out untouched) if it can't be opened
+bool load_saved_time(const std::filesystem::path &path , duration_ns &out);
+
+/// ~/.clc/timers holds the whole stopwatch_set : "clcset2" then one "<ns> <countdown ns> <name>"
+/// line per timer (countdown 0 counts up) . clcset1 files , "<ns> <name>" lines , still load
+constexpr const char saved_set_magic[] {"clcset2"};
+constexpr const char saved_set_magic_v1[] {"clcset1"};
+
+struct saved_timer
+{
+    std::string name;
+    int64_t total_ns = 0;
+    int64_t target_ns = 0;
+};
+
+/// false if the file is missing or isn't a clcset file
+bool load_saved_set(const std::filesystem::path &path , std::vector<saved_timer> &out);
+
+/// enqueue-to-on-disk latency , bucket i counts requests that took [2^i , 2^(i+1)) ns
+struct io_stats
+{
+    static constexpr size_t bucket_count = 48;
+    uint64_t latency_buckets[bucket_count] {};
+    uint64_t requests = 0;
+    uint64_t writes = 0;
+    uint64_t dropped = 0;   /// queue was full , the request was thrown away (laps stay pending and retry)
+    uint64_t waited = 0;    /// queue was full for a state change or flush , the producer waited for the worker instead
+    uint64_t max_queued = 0;
+};
+
+void print_io_stats(const io_stats &stats);
+
+/// the one thread that touches the disk while clc runs : ~/.clc/lt , the journal and log lines
+///
+/// the main loop hands it requests through a bounded lock-free spsc queue , publish() and
+/// log() never lock and never do io . the worker drains the queue and writes at most once
+/// per interval : while running every interval , while paused only if something changed .
+/// SIGINT and SIGTERM are taken by the same worker (signalfd) , it writes one last time and
+/// exits the process (with set_exit_laps that includes the laps not handed over yet)
+///
+/// with a journal every published event becomes a record , appended in the same batch as lt
+/// (plus a checkpoint record per interval for every running timer) . laps only live in the journal
+///
+/// timer 0 goes to lt like it always did , the whole set goes to `timers` next to it
+///
+/// with a session history every run that ends (stop , reset while running , or clc exiting
+/// while it runs) becomes a session record , written in the same batch
+struct checkpointer
+{
+    /// call before any other thread exists (before the window / gl context) ,
+    /// SIGINT and SIGTERM get blocked for the whole process here , stop() gives the
+    /// calling thread its old mask back
+    /// events_journal can be null , otherwise it must stay open until stop()
+    /// live_export can be null too , otherwise every publish() also lands there right away
+    /// (on the calling thread , it's a memory write , not io)
+    /// history can be null , otherwise it must stay open until stop() like the journal
+    bool start(const std::filesystem::path &file , int64_t interval_ns , bool sync , journal *events_journal = nullptr , shm_export *live_export = nullptr , session_history *history = nullptr);
+    void stop();
+
+    /// producer side , one thread at a time (the spsc queue has one producer) :
+    /// clc calls these with main_timers_lock held , from the frontend or the control thread
+    /// event is what just happened to stopwatch_set timer `timer` , it goes to the journal
+    /// never dropped : on a full queue it wakes the worker and waits for room (a write at most)
+    void publish(size_t timer , const stopwatch &state , journal_event event , const char *name);
+    /// hands pending laps over , lap_batch per request , and moves laps.flushed past them
+    /// stops early (returns false) when the queue is full , the rest stay pending for next time
+    bool publish_laps(lap_ring &laps);
+    /// printf-like line printed by the worker , cut at ~120 chars
+    void log(const char *format , ...) __attribute__((format(printf, 2, 3)));
+
+    /// csv trace (--trace) : open before start() , then trace() hands one line to the worker ,
+    /// which appends it through a stdio buffer (flushed once per interval and at stop)
+    bool open_trace(const std::filesystem::path &path);
+    void trace(const char *format , ...) __attribute__((format(printf, 2, 3)));
+
+    /// write the last published state now and wait for it , used on q and at exit
+    bool flush();
+
+    /// runs on the worker right before SIGINT / SIGTERM end the process (after the last save) ,
+    /// for state that only a normal return would undo (the terminal of clc --headless) , null clears it
+    void set_exit_hook(void (*hook)());
+
+    /// laps still in the producers' ring when SIGINT / SIGTERM end the process : the worker takes
+    /// them itself under `lock` (the lock every producer holds around the ring) before the last save
+    void set_exit_laps(lap_ring *laps , std::mutex *lock);
+
+    io_stats stats() const;
+
+    static constexpr size_t lap_batch = 8;
+
+    ~checkpointer() { stop(); }
+
+private:
+    struct request
+    {
+        enum kind_t : uint8_t { state_update , log_line , flush_now , lap_records , trace_line } kind = state_update;
+        int64_t enqueue_ns = 0; /// CLOCK_MONOTONIC (pacing_now_ns) , --clock coarse would make the io stats 4 ms steps
+        stopwatch state;
+        journal_record records[lap_batch] {}; /// state_update uses the first one
+        uint8_t record_count = 0;
+        uint64_t flush_id = 0;
+        uint8_t timer = 0;
+        char text[120] {}; /// log or trace line , or the timer name for state_update
+    };
+
+    /// wait_for_room : don't drop on a full queue , wake the worker until it takes the item
+    bool push(const request &item , bool urgent , bool wait_for_room = false);
+    void run();
+    bool write_state(const std::vector<stopwatch> &states , const std::vector<std::string> &names , bool periodic);
+    void record_latency(int64_t enqueue_ns , int64_t done_ns);
+    /// worker only , queues a session for the run `before` had going , which ended at `end`
+    void end_run(size_t timer , const stopwatch &before , clc_clock::time_point end);
+
+    std::filesystem::path file_path;
+    std::filesystem::path set_file_path;
+    int64_t interval = 0;
+    bool sync_writes = false;
+    journal *events = nullptr;
+    shm_export *live = nullptr;
+    session_history *sessions = nullptr;
+    FILE *trace_file = nullptr;               /// worker only once start() ran
+
+    spsc_queue<request, 1024> queue;
+    std::vector<stopwatch> producer_states;   /// main thread copy , what flush() falls back on
+    std::vector<std::string> producer_names;
+    std::string set_text;                     /// worker only , reused for the timers file
+    std::vector<journal_record> batch;        /// worker only
+    std::vector<int64_t> batch_enqueue_ns;    /// worker only
+    std::vector<session_record> session_batch; /// worker only
+
+    std::atomic<uint64_t> latency_buckets[io_stats::bucket_count] {};
+    std::atomic<uint64_t> request_count {0} , write_count {0} , dropped_count {0} , waited_count {0} , max_queued {0};
+
+    std::mutex flush_mutex;
+    std::condition_variable flush_done;
+    uint64_t flush_requested = 0;
+    uint64_t flush_completed = 0;
+    bool flush_ok = false;
+
+    std::thread worker;
+    int signal_fd = -1;
+    int wake_fd = -1;
+    sigset_t old_signal_mask {};
+    bool signals_blocked = false;
+    std::atomic<bool> quit {false};
+    std::atomic<void (*)()> exit_hook {nullptr};
+    std::atomic<lap_ring *> exit_laps {nullptr};
+    std::atomic<std::mutex *> exit_laps_lock {nullptr};
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "clc_pacing.h"
+
+/// where one turn of the window loop spends its time , in loop order
+enum class profile_phase : uint8_t
+{
+    wait,   /// RGFW_waitForEvent , sleeping is fine here
+    events, /// RGFW_window_checkEvent and the key handlers
+    format, /// t_str_fucn , lap list and the rest of the per-frame state
+    pace,   /// fixed fps deadline sleep
+    text,   /// text_layer (or glyph_renderer_draw_text in the fallback)
+    shapes,
+    swap,
+};
+constexpr size_t profile_phase_count = 7;
+
+const char *profile_phase_name(profile_phase phase);
+
+/// per-phase timings of the window loop , for the p overlay and the --trace csv
+/// costs two clock reads per phase while enabled and one branch per phase while not
+/// times are CLOCK_MONOTONIC (pacing_now_ns) like the pacer , whatever --clock picked : a coarse
+/// clc clock would turn every phase into 0 or a whole tick
+struct frame_profiler
+{
+    bool enabled = false;
+
+    /// the turn that just ended , what the csv gets
+    int64_t last[profile_phase_count] {};
+    int64_t last_start_ns = 0;
+    bool last_drew = false;
+    uint64_t turns = 0;
+
+    void add(profile_phase phase , int64_t ns)
+    {
+        current[size_t(phase)] += ns;
+    }
+
+    /// closes the previous turn (drew = it swapped) and opens the next one
+    void next_turn(bool drew , int64_t now_ns);
+
+    struct summary
+    {
+        double avg_ms[profile_phase_count] {}; /// per drawn frame
+        double max_ms[profile_phase_count] {};
+        double cpu_percent = 0.0;              /// whole process , every thread
+        uint64_t frames = 0;
+    };
+    /// everything since the last call , then starts over
+    summary take_summary();
+
+private:
+    int64_t current[profile_phase_count] {};
+    int64_t current_start_ns = 0;
+
+    int64_t sum[profile_phase_count] {};
+    int64_t max[profile_phase_count] {};
+    uint64_t frames = 0;
+    int64_t summary_wall_ns = 0;
+    int64_t summary_cpu_ns = 0;
+};
+
+/// { scoped_phase timing(profiler, profile_phase::swap); ... }
+/// or done() where the phase ends before the scope does
+struct scoped_phase
+{
+    scoped_phase(frame_profiler &owner , profile_phase which)
+        : profiler(owner) , phase(which) , start_ns(owner.enabled ? pacing_now_ns() : -1)
+    {
+    }
+
+    ~scoped_phase() { done(); }
+
+    void done()
+    {
+        if(start_ns >= 0)
+        {
+            profiler.add(phase, pacing_now_ns() - start_ns);
+            start_ns = -1;
+        }
+    }
+
+    scoped_phase(const scoped_phase &) = delete;
+    scoped_phase &operator=(const scoped_phase &) = delete;
+
+private:
+    frame_profiler &profiler;
+    profile_phase phase;
+    int64_t start_ns;
+};
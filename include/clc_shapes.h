@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "clc_gl.h"
+
+/// retained 2d shapes (rings , arcs , circles , rectangles)
+/// vertices are built once when a shape is added and live in one vbo ,
+/// drawing a shape is just a glDrawArrays over its range
+///
+/// rings are stored as a full triangle strip starting at start_angle , so a progress ring
+/// draws a prefix of it (draw with fraction < 1) and never regenerates vertices
+///
+/// same virtual coordinates as text_layer (top left origin , view_width x view_height)
+struct shape_layer
+{
+    using shape_id = size_t;
+
+    bool create(float view_width , float view_height);
+    void destroy();
+
+    /// filled annulus from inner_radius to outer_radius , angles in radians clockwise from 3 o'clock
+    shape_id add_ring(float cx , float cy , float inner_radius , float outer_radius , int segments , float start_angle = 0.0f , float sweep = 6.2831853f);
+    /// outline of a circle , line_width wide and centered on r
+    shape_id add_circle(float cx , float cy , float r , int segments , float line_width = 2.0f);
+    /// open arc outline , sweep in radians
+    shape_id add_arc(float cx , float cy , float r , int segments , float start_angle , float sweep , float line_width = 2.0f);
+    shape_id add_rect(float x , float y , float width , float height);
+    /// moves / resizes a rect in place (4 vertices re-uploaded) , for bars that change every frame
+    void set_rect(shape_id id , float x , float y , float width , float height);
+
+    /// fraction only matters for rings and arcs : 0..1 of their sweep gets drawn
+    void draw(shape_id id , float r , float g , float b , float a , float fraction = 1.0f);
+
+    size_t shape_count() const { return shapes.size(); }
+
+    /// vertex generation is public so it can be benchmarked without a context
+    static void ring_vertices(std::vector<float> &out , float cx , float cy , float inner_radius , float outer_radius , int segments , float start_angle , float sweep);
+
+private:
+    struct shape
+    {
+        GLint first = 0;
+        GLsizei count = 0;
+        int segments = 0; /// 0 for shapes that can't be partially drawn
+    };
+
+    shape_id add(const std::vector<float> &shape_vertices , int segments);
+    void flush();
+
+    GLuint program = 0 , vao = 0 , vbo = 0;
+    GLint color_location = -1 , view_location = -1;
+    float view_w = 0 , view_h = 0;
+
+    std::vector<shape> shapes;
+    std::vector<float> vertices; /// x , y pairs of every shape , the tail past uploaded_floats is not on the gpu yet
+    size_t uploaded_floats = 0;
+    size_t vbo_capacity_floats = 0;
+};
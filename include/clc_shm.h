@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <sched.h>
+
+/// /dev/shm/clc-<uid> : live state of every timer for status bars and monitoring agents
+///
+/// one writer (clc) and any number of readers , guarded by a seqlock : the writer makes seq
+/// odd , writes , makes it even again . readers copy what they need and retry if seq was odd
+/// or moved meanwhile . readers never write to the segment , so they can't slow clc down
+///
+/// times are CLOCK_MONOTONIC ns whatever --clock is , a reader gets the elapsed time with
+///   saved_ns + (running ? now_monotonic - start_ns : 0)
+/// and clock_gettime(CLOCK_MONOTONIC) is a vdso read , no syscall (see clc_shm_elapsed_ns)
+/// with --suspend count a running timer's time asleep only shows up once clc updates it again
+/// a countdown has target_ns set , what's left of it is clc_shm_shown_ns
+/// a segment can outlive its clc (signal , crash) : check clc_shm_writer_alive before trusting running
+constexpr const char clc_shm_magic[8] {"clcshm2"};
+constexpr size_t clc_shm_max_timers = 64; /// stopwatch_set::max_timers
+
+struct clc_shm_timer
+{
+    int64_t saved_ns;  /// elapsed before the current run
+    int64_t start_ns;  /// CLOCK_MONOTONIC when the current run started
+    int64_t target_ns; /// countdown length , 0 counts up
+    uint32_t running;
+    char name[36];     /// '\0' terminated , cut if longer
+};
+static_assert(sizeof(clc_shm_timer) == 64, "one timer per cache line");
+
+struct clc_shm_layout
+{
+    char magic[8];
+    std::atomic<uint32_t> seq;
+    uint32_t count;       /// valid entries in timers
+    int32_t writer_pid;
+    uint32_t alive;       /// 0 once clc exited normally , a crash or a signal leaves it 1 (clc_shm_writer_alive)
+    int64_t updated_ns;   /// CLOCK_MONOTONIC of the last write
+    char padding[32];
+    clc_shm_timer timers[clc_shm_max_timers];
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seq is shared between processes");
+
+/// reader side , header only so other programs can copy this file and nothing else
+enum class clc_shm_status
+{
+    ok,
+    missing, /// no such timer
+    busy,    /// seq stayed odd : a write is in flight , or the writer died in the middle of one
+};
+
+/// retries while a write is in flight (a few ns) , spins clc_shm_spins times then yields ,
+/// gives up with busy after clc_shm_yields yields : a clc ended by a signal mid-update leaves
+/// seq odd forever and a reader must not hang on it
+constexpr unsigned clc_shm_spins = 4096;
+constexpr unsigned clc_shm_yields = 64;
+
+inline clc_shm_status clc_shm_read(const clc_shm_layout *shm , size_t index , clc_shm_timer &out)
+{
+    for (unsigned tries = 0; tries < clc_shm_spins + clc_shm_yields; tries++)
+    {
+        if(tries >= clc_shm_spins)
+        {
+            sched_yield();
+        }
+        uint32_t before = shm->seq.load(std::memory_order_acquire);
+        if(before & 1)
+        {
+            continue;
+        }
+        bool exists = index < shm->count && index < clc_shm_max_timers;
+        if(exists)
+        {
+            out = shm->timers[index];
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(shm->seq.load(std::memory_order_relaxed) == before)
+        {
+            return exists ? clc_shm_status::ok : clc_shm_status::missing;
+        }
+    }
+    return clc_shm_status::busy;
+}
+
+/// false once the clc that wrote the segment is gone : it exited (alive 0) or its pid no longer
+/// exists . SIGINT / SIGTERM end clc with _Exit and leave alive at 1 , only the pid tells then
+/// (the worker can't write the segment there , the main thread may be mid-update)
+inline bool clc_shm_writer_alive(const clc_shm_layout *shm)
+{
+    if(!shm->alive)
+    {
+        return false;
+    }
+    return kill(shm->writer_pid, 0) == 0 || errno == EPERM;
+}
+
+inline int64_t clc_shm_elapsed_ns(const clc_shm_timer &timer)
+{
+    if(!timer.running)
+    {
+        return timer.saved_ns;
+    }
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timer.saved_ns + (int64_t(now.tv_sec) * 1000000000 + now.tv_nsec - timer.start_ns);
+}
+
+/// what clc's digits show : elapsed , or what's left of a countdown (never below zero)
+inline int64_t clc_shm_shown_ns(const clc_shm_timer &timer)
+{
+    int64_t elapsed_ns = clc_shm_elapsed_ns(timer);
+    if(timer.target_ns == 0)
+    {
+        return elapsed_ns;
+    }
+    return timer.target_ns > elapsed_ns ? timer.target_ns - elapsed_ns : 0;
+}
+
+struct stopwatch;
+
+/// writer side , clc owns the segment from open() to close()
+struct shm_export
+{
+    /// false when another live clc of this user already writes it (flock) or it can't be made
+    bool open();
+    /// marks the segment dead (alive = 0) and unlinks it
+    void close();
+
+    /// one timer changed , call under the same single-writer rule as checkpointer::publish
+    void update(size_t index , const stopwatch &state , const char *name);
+
+    bool is_open() const { return shm != nullptr; }
+
+    ~shm_export() { close(); }
+
+private:
+    clc_shm_layout *shm = nullptr;
+    int lock_fd = -1;
+    char shm_name[32] {};
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// bounded lock-free queue for exactly one producer thread and one consumer thread
+/// try_push fails when full instead of waiting , the caller decides what to drop
+template <typename T , size_t capacity>
+struct spsc_queue
+{
+    static_assert(capacity != 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    bool try_push(const T &item)
+    {
+        size_t write = tail.load(std::memory_order_relaxed);
+        if(write - cached_head == capacity)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if(write - cached_head == capacity)
+            {
+                return false;
+            }
+        }
+        items[write & (capacity - 1)] = item;
+        tail.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item)
+    {
+        size_t read = head.load(std::memory_order_relaxed);
+        if(read == cached_tail)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if(read == cached_tail)
+            {
+                return false;
+            }
+        }
+        item = items[read & (capacity - 1)];
+        head.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// exact for the calling side's own view , approximate for the other side
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    /// producer and consumer indexes live on their own cache lines
+    alignas(64) std::atomic<size_t> tail {0};
+    size_t cached_head = 0; /// producer only
+    alignas(64) std::atomic<size_t> head {0};
+    size_t cached_tail = 0; /// consumer only
+    alignas(64) std::array<T, capacity> items {};
+};
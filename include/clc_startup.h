@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// startup phase timer , on with --startup-times or CLC_STARTUP_TIMES=1
+/// mark() after each phase , report() prints how long every phase took and the running total
+/// the first line is exec -> main : from the launcher's CLOCK_MONOTONIC stamp in CLC_EXEC_NS
+/// when there is one (bench/clc_launch) , else from /proc/self/stat (only 1/CLK_TCK resolution)
+struct startup_timer
+{
+    bool enabled = false;
+
+    /// first thing in main , requested is the command line flag
+    void begin(bool requested);
+    void mark(const char *phase);
+    void report() const;
+
+    /// ms from exec to the last mark , -1 when disabled
+    double total_ms() const;
+
+private:
+    static constexpr size_t max_phases = 16;
+    struct phase
+    {
+        const char *name;
+        int64_t end_ns;
+    };
+
+    int64_t exec_ns = 0; /// process start on the CLOCK_BOOTTIME line
+    phase phases[max_phases] {};
+    size_t count = 0;
+};
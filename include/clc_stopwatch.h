@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clc_clock.h"
+
+/// clc keeps every time as int64 nanoseconds of a monotonic clock
+/// it used to be double seconds summed on every stop , that drift after long sessions
+using duration_ns = std::chrono::duration<int64_t, std::nano>;
+
+struct stopwatch
+{
+    duration_ns saved {0};               /// sum of all finished runs
+    clc_clock::time_point start_time {}; /// only valid when running
+    int64_t start_suspended_ns = 0;      /// clock_suspended_ns() at start_time , the boottime half of the stamp
+    duration_ns target {0};              /// countdown length , 0 counts up (see clc_alarm.h)
+    bool running = false;
+
+    void start(clc_clock::time_point now)
+    {
+        if(!running)
+        {
+            /// a countdown that reached zero starts over
+            if(finished())
+            {
+                saved = duration_ns::zero();
+            }
+            start_time = now;
+            start_suspended_ns = clock_suspended_ns();
+            running = true;
+        }
+    }
+
+    void stop(clc_clock::time_point now)
+    {
+        if(running)
+        {
+            saved += now - start_time;
+            running = false;
+        }
+    }
+
+    void toggle(clc_clock::time_point now)
+    {
+        running ? stop(now) : start(now);
+    }
+
+    /// running timer keeps running from zero
+    void reset(clc_clock::time_point now)
+    {
+        saved = duration_ns::zero();
+        start_time = now;
+        start_suspended_ns = clock_suspended_ns();
+    }
+
+    /// how long the machine slept since the current run started , counted in elapsed()
+    /// only with suspend_policy::count
+    int64_t slept_ns() const
+    {
+        return running ? clock_suspended_ns() - start_suspended_ns : 0;
+    }
+
+    duration_ns elapsed(clc_clock::time_point now) const
+    {
+        return running ? saved + (now - start_time) : saved;
+    }
+
+    bool counts_down() const
+    {
+        return target.count() != 0;
+    }
+
+    /// stopped at zero by its alarm
+    bool finished() const
+    {
+        return counts_down() && !running && saved >= target;
+    }
+
+    /// what the digits show : elapsed , or what's left of a countdown (never below zero)
+    duration_ns shown(clc_clock::time_point now) const
+    {
+        return counts_down() ? std::max(target - elapsed(now), duration_ns::zero()) : elapsed(now);
+    }
+};
+
+/// many independent stopwatches in one process , one window and one gl context for all of them
+/// kept as structure of arrays so a frame that needs every elapsed time is one tight loop
+/// index 0 always exists , it is the timer that ~/.clc/lt has always held
+struct stopwatch_set
+{
+    /// journal records keep the index in 8 bits and the frontends list them on one screen
+    static constexpr size_t max_timers = 64;
+
+    std::vector<int64_t> saved_ns;
+    std::vector<int64_t> start_ns;
+    std::vector<int64_t> start_suspended_ns;
+    std::vector<int64_t> target_ns;
+    std::vector<uint8_t> running;
+    std::vector<std::string> names;
+    size_t active = 0;
+
+    stopwatch_set()
+    {
+        add("main");
+    }
+
+    size_t size() const
+    {
+        return saved_ns.size();
+    }
+
+    /// returns the new index , or max_timers when the set is full
+    size_t add(std::string name)
+    {
+        if(size() == max_timers)
+        {
+            return max_timers;
+        }
+        saved_ns.push_back(0);
+        start_ns.push_back(0);
+        start_suspended_ns.push_back(0);
+        target_ns.push_back(0);
+        running.push_back(0);
+        names.push_back(std::move(name));
+        return size() - 1;
+    }
+
+    stopwatch get(size_t i) const
+    {
+        stopwatch result;
+        result.saved = duration_ns(saved_ns[i]);
+        result.start_time = clc_clock::time_point(duration_ns(start_ns[i]));
+        result.start_suspended_ns = start_suspended_ns[i];
+        result.target = duration_ns(target_ns[i]);
+        result.running = running[i] != 0;
+        return result;
+    }
+
+    void put(size_t i , const stopwatch &state)
+    {
+        saved_ns[i] = state.saved.count();
+        start_ns[i] = state.start_time.time_since_epoch().count();
+        start_suspended_ns[i] = state.start_suspended_ns;
+        target_ns[i] = state.target.count();
+        running[i] = state.running ? 1 : 0;
+    }
+
+    int64_t elapsed_ns(size_t i , clc_clock::time_point now) const
+    {
+        return saved_ns[i] + (running[i] ? now.time_since_epoch().count() - start_ns[i] : 0);
+    }
+
+    int64_t shown_ns(size_t i , clc_clock::time_point now) const
+    {
+        int64_t elapsed = elapsed_ns(i, now);
+        return target_ns[i] != 0 ? std::max<int64_t>(target_ns[i] - elapsed, 0) : elapsed;
+    }
+
+    /// every timer at once , out needs size() slots
+    void elapsed_all(clc_clock::time_point now , int64_t *out) const
+    {
+        const int64_t now_ns = now.time_since_epoch().count();
+        for (size_t i = 0; i < size(); i++)
+        {
+            out[i] = saved_ns[i] + int64_t(running[i]) * (now_ns - start_ns[i]);
+        }
+    }
+
+    size_t running_count() const
+    {
+        size_t count = 0;
+        for (uint8_t value : running)
+        {
+            count += value;
+        }
+        return count;
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "clc_gl.h"
+
+/// retained text for the main window
+/// every glyph clc can show is drawn once (with glyph) into an atlas texture at startup ,
+/// after that static strings cost nothing and the time string only rewrites the quads of
+/// the characters that changed . all of it goes out in one draw call , a dynamic line with
+/// its own color (set_dynamic_color) splits that in three
+///
+/// the atlas is also cached in a file keyed by the font , so later starts skip glyph entirely
+///
+/// coordinates are the same virtual space that glyph_renderer_set_projection got (800x600)
+struct text_layer
+{
+    /// draws `text` with the font at (x , y) in atlas coordinates , clc.cpp wraps glyph here
+    /// so this file doesn't need glyph.h
+    using draw_text_fn = void (*)(void *ctx, const char *text, float x, float y);
+
+    /// characters the dynamic lines can use , everything else is skipped
+    static constexpr const char dynamic_chars[] {"0123456789.:/"};
+    static constexpr size_t max_dynamic = 32;
+    static constexpr size_t dynamic_lines = 16;
+
+    struct glyph_box
+    {
+        float x0 = 0 , y0 = 0 , x1 = 0 , y1 = 0; /// ink offset from the draw point
+        float u0 = 0 , v0 = 0 , u1 = 0 , v1 = 0;
+        float advance = 0;
+    };
+
+    /// caller must set glyph's projection to atlas_width x atlas_height() before and back after
+    /// with a cache_path the finished atlas is also written there for load_cache
+    bool create(float font_size , float view_width , float view_height , const std::vector<const char *> &static_texts , draw_text_fn draw_text , void *ctx , const std::filesystem::path &cache_path = {} , uint64_t cache_key = 0);
+    /// atlas from a file create() wrote , no font and no glyph needed . false if it's missing or stale
+    bool load_cache(const std::filesystem::path &path , uint64_t key , float view_width , float view_height , size_t static_count);
+    void destroy();
+
+    /// hash of the font file contents , the size and the atlas strings , 0 if the font can't be read
+    static uint64_t cache_key(const char *font_path , float font_size , const std::vector<const char *> &static_texts);
+
+    int atlas_width() const { return atlas_w; }
+    int atlas_height() const { return atlas_h; }
+    static void atlas_size_for(float font_size , size_t static_count , int &width , int &height);
+
+    /// static string `index` (order of create) with its draw point at (x , y)
+    void place_static(size_t index , float x , float y);
+
+    /// replaces dynamic line `line` , only quads whose char or x moved get uploaded
+    /// len 0 hides the line , a space moves the pen one digit wide , scale shrinks the atlas glyphs
+    void set_dynamic(size_t line , const char *text , size_t len , float x , float y , float scale = 1.0f);
+
+    /// dynamic line `line` stops using draw's color and keeps this one until it's cleared
+    void set_dynamic_color(size_t line , float r , float g , float b , float a);
+    /// back to draw's color (and one draw call)
+    void clear_dynamic_color(size_t line);
+
+    void draw(float r , float g , float b , float a);
+
+private:
+    struct vertex
+    {
+        float x , y , u , v;
+    };
+    using quad = std::array<vertex, 6>;
+
+    static quad make_quad(const glyph_box &box , float x , float y , float scale = 1.0f);
+    bool init_gpu_objects(size_t static_count);
+    bool save_cache(const std::filesystem::path &path , uint64_t key , float font_size , const std::vector<unsigned char> &coverage) const;
+    void upload(size_t first_quad , size_t count);
+
+    GLuint program = 0 , vao = 0 , vbo = 0 , atlas = 0;
+    GLint color_location = -1 , view_location = -1;
+    int atlas_w = 0 , atlas_h = 0;
+    float view_w = 0 , view_h = 0;
+
+    std::array<glyph_box, sizeof(dynamic_chars) - 1> dynamic_boxes {};
+    std::vector<glyph_box> static_boxes;
+
+    /// cpu copy of the vbo : static quads first then max_dynamic slots per dynamic line
+    std::vector<quad> quads;
+    struct dynamic_line
+    {
+        std::array<char, max_dynamic> shown {};
+        std::array<float, max_dynamic> shown_x {};
+        size_t len = 0;
+        float y = 0.0f;
+        float scale = 1.0f;
+        bool own_color = false;
+        std::array<float, 4> color {};
+    };
+    std::array<dynamic_line, dynamic_lines> lines {};
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <mutex>
+
+#include "clc_alarm.h"
+#include "clc_laps.h"
+#include "clc_persist.h"
+#include "clc_stopwatch.h"
+
+/// clc --headless : same stopwatch and saving as the window , drawn in the terminal
+/// no window , no gl , no font . only the characters that changed get rewritten
+/// one row per timer , keys act on the one marked with > , its laps are listed below :
+/// space start/stop , r reset , l lap , up / down scroll laps , tab / 1-9 pick , n new ,
+/// q / esc / ctrl+c quit
+/// lock is held while timers and laps are read or changed , wake_fd (an eventfd , or -1)
+/// gets written when someone else (clc --control) changed them
+/// alarms is opened without a thread , its timerfd is polled next to stdin
+int run_tty(stopwatch_set &timers , lap_ring &laps , checkpointer &saver , std::mutex &lock , int wake_fd , alarm_timer &alarms);
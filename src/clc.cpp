@@ -1,174 +1,884 @@
-#include "../include/clc.h"
-
-namespace fs = std::filesystem;
-
-double saved_time {0} , output_time {0} , rus_time {0};
-const fs::path home_dir = getenv("HOME");
-const fs::path saved_time_file_path = home_dir / ".clc" / "lt";
-const char font_path[] {"/usr/share/clc/font.ttf"};
-
-std::string t_str = "";
-
-std::string t_str_fucn (double &time)
-{
-    std::string function_result = "";    
-    
-    if(time >= 3600)
-    {
-        int hour = time / 3600;
-        function_result += std::to_string(hour);
-        function_result += ".";
-
-        int min = std::fmod(time , 3600) / 60;
-
-        function_result +=std::to_string(min);
-        function_result += ".";        
-    }
-    else if (time >= 60)
-    {
-        int min = std::fmod(time,3600) / 60;
-        function_result += std::to_string(min);
-        function_result += ".";   
-    }
-    
-        double sec = std::fmod(time , 60);        
-        function_result +=std::to_string(sec);
-
-        function_result.erase(8);    
-    return function_result;
-}
-
-
-void save_time()
-{
-    double total_ms = saved_time;
-    if (!fs::exists(saved_time_file_path.parent_path()))
-    {
-        fs::create_directory(saved_time_file_path.parent_path());
-    }
-    std::ofstream outFile(saved_time_file_path);
-    if (outFile.is_open())
-    {
-        outFile << total_ms;
-        outFile.close();
-        printf("clc. massage [alert] : last time got saved\n");
-    }
-    else
-    {
-        printf("clc. massage [error] : can't store last data time\n");
-    }
-
-    return ;
-}
-
-double load_time()
-{
-    std::ifstream inFile(saved_time_file_path);
-    double previous_time = 0;
-    if(inFile.is_open())
-    {
-        inFile >> previous_time;
-        inFile.close();
-        return previous_time;
-        printf("clc. massage [alert] : last saved time loaded succesfully%f\n" ,previous_time);
-    }
-    else
-    {
-        printf("clc. massage [error] : failed to open ~/.clc/lt file.\nclc could't load your last time_point\n");
-        return 0;
-    }
-}
-
-
-int main()
-{
-    std::atexit(save_time);
-    
-    bool order_time_stop = true;
-
-    double last_time_time = load_time();
-    std::printf("clc. massage [alert]  : loaded time = %f\n",load_time());
-
-    RGFW_window* RGFW_window_obj = RGFW_createWindow("clc.", 0, 0, 500, 300, RGFW_windowOpenGL | RGFW_windowNoBorder | RGFW_windowNoResize | RGFW_windowCenter);
-    RGFW_window_makeCurrentContext_OpenGL(RGFW_window_obj);
-    
-    glyph_gl_set_opengl_version(3, 3);
-    RGFW_window_show(RGFW_window_obj);
-    RGFW_window_setExitKey(RGFW_window_obj,RGFW_keyEscape);
-    glyph_renderer_t renderer = glyph_renderer_create(font_path, 135.0f,NULL, GLYPH_ENCODING_UTF8,NULL, 0);
-    glyph_renderer_set_projection(&renderer, 800, 600);
-    
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    std::chrono::time_point<std::chrono::high_resolution_clock> start_time; 
-    saved_time += last_time_time;
-    while(RGFW_window_shouldClose(RGFW_window_obj) == false)
-    {
-        RGFW_event RGFW_event_obj;
-
-        while(RGFW_window_checkEvent(RGFW_window_obj, &RGFW_event_obj))
-        {
-//          space
-            if(RGFW_event_obj.type == RGFW_keyPressed && RGFW_event_obj.button.value == RGFW_keySpace)    
-            {
-                /// stop and start timer proc
-                if(order_time_stop == true)
-                {
-                    order_time_stop = false;
-                    start_time = std::chrono::high_resolution_clock::now();
-                }
-                else
-                {
-                    order_time_stop = true;
-                    saved_time += output_time;
-                }
-            }
-//          r
-            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyR)
-            {
-                saved_time = 0;
-                last_time_time = 0;
-                output_time = 0;
-            }
-//          q
-            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyQ)
-            {
-                save_time();
-                return 0;
-            }
-
-        }
-
-//      graphic interface    
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        if(order_time_stop)
-        {
-            rus_time = saved_time;
-            t_str = t_str_fucn(rus_time);
-                               
-            glyph_renderer_draw_text(&renderer, t_str.c_str(),170.0f, 350.0f, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
-        }
-        else if (!order_time_stop)
-        {    
-            auto now_time = std::chrono::high_resolution_clock::now();
-            output_time = std::chrono::duration<double>(now_time - start_time).count();
-
-            rus_time = output_time + saved_time;
-            t_str = t_str_fucn(rus_time);
-       
-            glyph_renderer_draw_text(&renderer, t_str.c_str(),170.0f, 350.0f, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
-        }
-
-        glyph_renderer_draw_text(&renderer,"clc.", 10, 100, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
-        RGFW_window_swapBuffers_OpenGL(RGFW_window_obj);
-
-        drawCircle(200,200,10, 10);
-
-    }
-    RGFW_window_close(RGFW_window_obj);
-
-    return 0;
-}
+#include "../include/clc.h"
+
+namespace fs = std::filesystem;
+
+stopwatch_set main_timers;
+lap_ring main_laps;
+/// held by the frontend while it reads or changes timers and laps , and by the control thread
+/// for each batch of commands (checkpointer::publish only ever runs under it)
+std::mutex main_timers_lock;
+/// globals die in reverse order : the journal has to outlive the checkpointer's last write
+journal main_journal;
+/// ~/.clc/sessions and its day index , written by the checkpointer's worker like the journal
+session_history main_history;
+/// /dev/shm/clc-<uid> , what status bars read
+shm_export main_live;
+checkpointer main_checkpoint;
+startup_timer main_startup;
+/// key press -> handled , for --input-stats
+input_latency main_input_latency;
+/// declared after the checkpointer so it stops before that one goes away
+control_server main_control;
+std::atomic<bool> control_changed {false};
+int tty_wake_fd = -1;
+const fs::path home_dir = getenv("HOME");
+const fs::path saved_time_file_path = home_dir / ".clc" / "lt";
+const fs::path journal_file_path = home_dir / ".clc" / "journal";
+const fs::path timers_file_path = home_dir / ".clc" / "timers";
+const fs::path sessions_file_path = home_dir / ".clc" / "sessions";
+/// the journal gets folded into one snapshot record past this many records (40MB)
+constexpr size_t journal_compact_records = 1 << 20;
+const char font_path[] {"/usr/share/clc/font.ttf"};
+
+t_str_buf t_str {};
+/// rows of the lap list under the big digits , newest on top
+constexpr size_t lap_rows = 4;
+
+void publish_timer(size_t index , journal_event event)
+{
+    main_checkpoint.publish(index, main_timers.get(index), event, main_timers.names[index].c_str());
+}
+
+
+/// the checkpointer queue takes one producer at a time : the control thread has to be gone
+/// before the pushes below , which run outside the lock (flush waits for the worker)
+void save_time()
+{
+    main_control.stop();
+    {
+        std::lock_guard<std::mutex> guard(main_timers_lock);
+        for (size_t i = 0; i < main_timers.size(); i++)
+        {
+            publish_timer(i, journal_event::checkpoint);
+        }
+        main_checkpoint.publish_laps(main_laps);
+    }
+    if (main_checkpoint.flush())
+    {
+        main_checkpoint.log("clc. massage [alert] : last time got saved");
+    }
+    else
+    {
+        main_checkpoint.log("clc. massage [error] : can't store last data time");
+    }
+
+    return ;
+}
+
+void show_io_stats()
+{
+    print_io_stats(main_checkpoint.stats());
+}
+
+void show_input_latency()
+{
+    print_input_latency(main_input_latency);
+}
+
+/// the alarm thread calls this when a countdown is due , the loop finds it in take_due
+void wake_for_alarm(void *)
+{
+    RGFW_stopCheckEvents();
+}
+
+/// control_server calls these after commands changed something , from its own thread
+void wake_window(void *)
+{
+    control_changed = true;
+    RGFW_stopCheckEvents();
+}
+
+void wake_tty(void *)
+{
+    uint64_t one = 1;
+    ssize_t ignored = write(tty_wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+/// text_layer builds its atlas through this , so only this file knows about glyph
+void draw_with_glyph(void *ctx, const char *text, float x, float y)
+{
+    glyph_renderer_draw_text(static_cast<glyph_renderer_t *>(ctx), text, x, y, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+}
+
+
+bool has_flag(int argc, char **argv, const char *flag)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], flag) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+int main(int argc, char **argv)
+{
+    /// clc --report <range> only reads the history index and leaves , nothing else starts
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--report") == 0)
+        {
+            return print_report(sessions_file_path, argv[i + 1]);
+        }
+    }
+    main_startup.begin(has_flag(argc, argv, "--startup-times"));
+    /// for bench/startup.sh : draw one frame , print the phases and leave
+    const bool exit_after_first_frame = has_flag(argc, argv, "--exit-after-first-frame");
+
+    int64_t checkpoint_interval_ns = 5000000000;
+    bool checkpoint_sync = false;
+    bool io_stats_at_exit = false;
+    bool input_stats_at_exit = false;
+    bool headless = false;
+    bool control = false;
+    pacing_mode pacing = pacing_mode::vsync;
+    double target_fps = 60.0;
+    const char *trace_path = nullptr;
+    suspend_policy suspend = suspend_policy::skip;
+    latch_mode latch = latch_mode::late;
+    const char *countdown_text = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            double seconds = std::strtod(argv[++i], nullptr);
+            checkpoint_interval_ns = seconds > 0.01 ? std::llround(seconds * 1e9) : 10000000;
+        }
+        if(std::strcmp(argv[i], "--fsync") == 0)
+        {
+            checkpoint_sync = true;
+        }
+        if(std::strcmp(argv[i], "--io-stats") == 0)
+        {
+            io_stats_at_exit = true;
+        }
+        if(std::strcmp(argv[i], "--input-stats") == 0)
+        {
+            input_stats_at_exit = true;
+        }
+        if(std::strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        if(std::strcmp(argv[i], "--control") == 0)
+        {
+            control = true;
+        }
+        if(std::strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(!pacing_mode_from_name(argv[i], pacing))
+            {
+                printf("clc. massage [error] : unknown pacing %s (vsync , fixed , adaptive)\n", argv[i]);
+            }
+        }
+        if(std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            target_fps = std::strtod(argv[++i], nullptr);
+            pacing = pacing_mode::fixed;
+        }
+        if(std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+        if(std::strcmp(argv[i], "--suspend") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(!suspend_policy_from_name(argv[i], suspend))
+            {
+                printf("clc. massage [error] : unknown suspend policy %s (skip , count)\n", argv[i]);
+            }
+        }
+        if(std::strcmp(argv[i], "--countdown") == 0 && i + 1 < argc)
+        {
+            countdown_text = argv[++i];
+        }
+        if(std::strcmp(argv[i], "--latch") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(!latch_mode_from_name(argv[i], latch))
+            {
+                printf("clc. massage [error] : unknown latch %s (off , late , predict)\n", argv[i]);
+            }
+        }
+        if(std::strcmp(argv[i], "--clock") == 0 && i + 1 < argc)
+        {
+            clock_source source;
+            i++;
+            if(!clock_source_from_name(argv[i], source))
+            {
+                printf("clc. massage [error] : unknown clock %s (steady , raw , coarse , tsc)\n", argv[i]);
+            }
+            else if(!select_clock_source(source))
+            {
+                printf("clc. massage [error] : clock %s is not usable here , using steady\n", argv[i]);
+            }
+        }
+    }
+    /// after the loop , --clock can come after --suspend
+    if(!select_suspend_policy(suspend))
+    {
+        printf("clc. massage [error] : --suspend count needs --clock steady , time asleep won't be counted\n");
+    }
+    printf("clc. massage [alert] : clock source = %s , suspend = %s\n", clock_source_name(current_clock_source()), suspend_policy_name(current_suspend_policy()));
+    main_startup.mark("args + clock");
+
+    std::error_code dir_error;
+    fs::create_directories(saved_time_file_path.parent_path(), dir_error);
+
+    journal_summary history;
+    if(!main_journal.open(journal_file_path, journal_compact_records, history))
+    {
+        printf("clc. massage [error] : can't open ~/.clc/journal , events won't be recorded\n");
+    }
+    else if(history.records != 0)
+    {
+        printf("clc. massage [alert] : journal has %zu records , %lld runs%s\n", history.records, (long long)history.runs, history.running ? " (last one never stopped)" : "");
+    }
+    if(!main_history.open(sessions_file_path))
+    {
+        printf("clc. massage [error] : can't open ~/.clc/sessions , runs won't be kept for --report\n");
+    }
+    main_startup.mark("journal replay");
+
+    if(!main_live.open())
+    {
+        printf("clc. massage [error] : no /dev/shm/clc-%u export from this clc , status bars won't see its time\n", unsigned(getuid()));
+    }
+
+    if(trace_path != nullptr && !main_checkpoint.open_trace(trace_path))
+    {
+        printf("clc. massage [error] : can't open %s , no trace\n", trace_path);
+        trace_path = nullptr;
+    }
+
+    /// has to start before RGFW and the gl driver make their threads (signal mask)
+    if(!main_checkpoint.start(saved_time_file_path, checkpoint_interval_ns, checkpoint_sync, main_journal.is_open() ? &main_journal : nullptr, main_live.is_open() ? &main_live : nullptr, main_history.is_open() ? &main_history : nullptr))
+    {
+        printf("clc. massage [error] : periodic saving is off , time is only saved on q\n");
+    }
+    /// a signal exit keeps the laps the frontends haven't batched over yet
+    main_checkpoint.set_exit_laps(&main_laps, &main_timers_lock);
+    /// atexit runs backwards , so the stats come after the last save
+    if(io_stats_at_exit)
+    {
+        std::atexit(show_io_stats);
+    }
+    if(input_stats_at_exit)
+    {
+        std::atexit(show_input_latency);
+    }
+    std::atexit(save_time);
+    main_startup.mark("io thread");
+    
+    duration_ns previous {0};
+    if(load_saved_time(saved_time_file_path, previous))
+    {
+        printf("clc. massage [alert] : last saved time loaded succesfully %lld ns\n" ,(long long)previous.count());
+    }
+    else
+    {
+        printf("clc. massage [error] : failed to open ~/.clc/lt file.\nclc could't load your last time_point\n");
+    }
+    main_timers.saved_ns[0] = previous.count();
+    /// lt missing or broken , the journal still knows the total
+    if(main_timers.saved_ns[0] == 0 && history.total_ns != 0)
+    {
+        main_timers.saved_ns[0] = history.total_ns;
+        printf("clc. massage [alert] : time restored from ~/.clc/journal\n");
+    }
+    /// lt stays the home of timer 0 , the rest only live in ~/.clc/timers
+    std::vector<saved_timer> saved_set;
+    if(load_saved_set(timers_file_path, saved_set))
+    {
+        main_timers.target_ns[0] = saved_set[0].target_ns;
+        for (size_t i = 1; i < saved_set.size(); i++)
+        {
+            size_t index = main_timers.add(saved_set[i].name);
+            if(index == stopwatch_set::max_timers)
+            {
+                break;
+            }
+            main_timers.saved_ns[index] = saved_set[i].total_ns;
+            main_timers.target_ns[index] = saved_set[i].target_ns;
+        }
+        printf("clc. massage [alert] : %zu timers loaded\n", main_timers.size());
+    }
+    for (size_t i = 0; i < main_timers.size(); i++)
+    {
+        publish_timer(i, journal_event::checkpoint);
+    }
+    /// --countdown <length> : a new countdown , picked and started right away
+    duration_ns countdown_length;
+    if(countdown_text != nullptr && !parse_countdown(countdown_text, countdown_length))
+    {
+        printf("clc. massage [error] : bad countdown %s (90 , 90s , 5m , 1.5h)\n", countdown_text);
+    }
+    else if(countdown_text != nullptr)
+    {
+        size_t index = main_timers.add(std::string("countdown ") + countdown_text);
+        if(index != stopwatch_set::max_timers)
+        {
+            stopwatch countdown;
+            countdown.target = countdown_length;
+            countdown.start(clc_clock::now());
+            main_timers.put(index, countdown);
+            main_timers.active = index;
+            publish_timer(index, journal_event::start);
+        }
+    }
+    main_startup.mark("load_time");
+
+    if(control)
+    {
+        tty_wake_fd = headless ? eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) : -1;
+        if(main_control.start(control_socket_path(), main_timers, main_laps, main_checkpoint, main_timers_lock, headless ? wake_tty : wake_window, nullptr))
+        {
+            printf("clc. massage [alert] : listening on %s\n", control_socket_path().c_str());
+        }
+        else
+        {
+            printf("clc. massage [error] : can't listen on %s (another clc has it ?)\n", control_socket_path().c_str());
+        }
+        main_startup.mark("control socket");
+    }
+
+    /// everything above is shared , the terminal frontend never touches RGFW or glyph
+    if(headless)
+    {
+        main_startup.report();
+        alarm_timer alarms;
+        alarms.open();
+        int result = run_tty(main_timers, main_laps, main_checkpoint, main_timers_lock, tty_wake_fd, alarms);
+        main_control.stop();
+        return result;
+    }
+
+    RGFW_window* RGFW_window_obj = RGFW_createWindow("clc.", 0, 0, 500, 300, RGFW_windowOpenGL | RGFW_windowNoBorder | RGFW_windowNoResize | RGFW_windowCenter);
+    main_startup.mark("RGFW_createWindow");
+    RGFW_window_makeCurrentContext_OpenGL(RGFW_window_obj);
+    /// the driver default is anything from tearing at thousands of fps to vsync , so say it
+    frame_pacer pacer;
+    pacer.begin(pacing, target_fps);
+    RGFW_window_swapInterval_OpenGL(RGFW_window_obj, pacer.swap_interval());
+    present_predictor predictor;
+    if(latch == latch_mode::predict)
+    {
+        bool oml = predictor.init(pacer.swap_interval());
+        printf("clc. massage [alert] : latch = predict , %s\n", oml ? "vblank times from GLX_OML_sync_control" : "no GLX_OML_sync_control , averaged swap times");
+    }
+    
+    glyph_gl_set_opengl_version(3, 3);
+    RGFW_window_show(RGFW_window_obj);
+    RGFW_window_setExitKey(RGFW_window_obj,RGFW_keyEscape);
+    /// countdowns stop themselves , even while the window sleeps in RGFW_waitForEvent
+    alarm_timer alarms;
+    alarms.open(wake_for_alarm, nullptr);
+    /// start , stop and laps take the time the x server saw the key , not when the loop got to it
+    key_stamper keys;
+    if(!keys.open())
+    {
+        printf("clc. massage [alert] : no XInput2 , keys are timed when the loop gets to them\n");
+    }
+    auto press_time = [&](unsigned long keysym)
+    {
+        int64_t now_ns = pacing_now_ns();
+        clc_clock::time_point now = clc_clock::now();
+        int64_t press_ns;
+        if(!keys.take_press(keysym, now_ns, press_ns))
+        {
+            main_input_latency.unstamped++;
+            return now;
+        }
+        main_input_latency.record(now_ns - press_ns);
+        return now - duration_ns(now_ns - press_ns);
+    };
+    main_startup.mark("context + show");
+    
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    /// "clc." and every digit get rasterized once and cached in ~/.clc/atlas-<key>.bin
+    /// with a good cache the ttf is never parsed , glyph_renderer_create only runs on a miss
+    /// if all of that fails we draw with glyph every frame like before
+    const std::vector<const char *> static_texts {"clc."};
+    bool gl_ready = clc_gl_load();
+    text_layer main_text;
+    bool use_text_layer = false;
+    glyph_renderer_t renderer {};
+
+    uint64_t atlas_key = text_layer::cache_key(font_path, 135.0f, static_texts);
+    char atlas_name[32];
+    snprintf(atlas_name, sizeof(atlas_name), "atlas-%016llx.bin", (unsigned long long)atlas_key);
+    const fs::path atlas_cache_path = saved_time_file_path.parent_path() / atlas_name;
+
+    if(gl_ready && atlas_key != 0)
+    {
+        use_text_layer = main_text.load_cache(atlas_cache_path, atlas_key, 800, 600, static_texts.size());
+    }
+    if(!use_text_layer)
+    {
+        renderer = glyph_renderer_create(font_path, 135.0f,NULL, GLYPH_ENCODING_UTF8,NULL, 0);
+        if(gl_ready)
+        {
+            int atlas_w, atlas_h;
+            text_layer::atlas_size_for(135.0f, static_texts.size(), atlas_w, atlas_h);
+            glyph_renderer_set_projection(&renderer, atlas_w, atlas_h);
+            use_text_layer = main_text.create(135.0f, 800, 600, static_texts, draw_with_glyph, &renderer, atlas_key != 0 ? atlas_cache_path : fs::path(), atlas_key);
+        }
+        glyph_renderer_set_projection(&renderer, 800, 600);
+    }
+    if(use_text_layer)
+    {
+        main_text.place_static(0, 10, 100);
+    }
+    else
+    {
+        printf("clc. massage [error] : text cache is off , drawing text directly\n");
+    }
+
+    main_startup.mark(use_text_layer ? "text atlas" : "glyph fallback");
+
+    shape_layer shapes;
+    shape_layer::shape_id dot_circle = 0;
+    bool use_shapes = gl_ready && shapes.create(800, 600);
+    if(use_shapes)
+    {
+        dot_circle = shapes.add_circle(200, 200, 10, 10);
+    }
+    /// f3 : frame time histogram , one bar per 0.5ms bucket along the bottom
+    frame_histogram frame_times;
+    bool show_frame_stats = false;
+    std::array<shape_layer::shape_id, frame_histogram::bucket_count> frame_bars {};
+    if(use_shapes)
+    {
+        for (size_t i = 0; i < frame_bars.size(); i++)
+        {
+            frame_bars[i] = shapes.add_rect(16.0f + 12.0f * float(i), 590.0f, 10.0f, 0.0f);
+        }
+    }
+    char frame_stats_str[2][24] {};
+    size_t frame_stats_len[2] {};
+    int64_t frame_stats_at_ns = 0;
+    uint64_t frame_stats_frames = 0;
+
+    /// p : avg/max ms of every loop phase per drawn frame (profile_phase order) and cpu % last ,
+    /// one row each with a bar , 16.7ms (or 100%) is the full bar
+    /// --trace <file.csv> : the same phases for every loop turn , drawn or not
+    frame_profiler profiler;
+    bool show_profile = false;
+    constexpr size_t profile_rows = profile_phase_count + 1;
+    constexpr float profile_colors[profile_rows][3] {
+        {0.4f, 0.4f, 0.4f}, {0.9f, 0.6f, 0.2f}, {0.9f, 0.9f, 0.3f}, {0.5f, 0.5f, 0.9f},
+        {0.3f, 0.8f, 0.9f}, {0.8f, 0.4f, 0.9f}, {0.9f, 0.3f, 0.3f}, {0.3f, 0.9f, 0.4f},
+    };
+    std::array<shape_layer::shape_id, profile_rows> profile_bars {};
+    if(use_shapes)
+    {
+        for (size_t i = 0; i < profile_bars.size(); i++)
+        {
+            profile_bars[i] = shapes.add_rect(440.0f, 256.0f + 22.0f * float(i), 0.0f, 14.0f);
+        }
+    }
+    char profile_str[profile_rows][24] {};
+    size_t profile_len[profile_rows] {};
+    int64_t profile_at_ns = 0;
+    bool drew_frame = false;
+    if(trace_path != nullptr)
+    {
+        profiler.enabled = true;
+        char header[120] = "turn,start_ns";
+        for (size_t i = 0; i < profile_phase_count; i++)
+        {
+            std::strcat(header, ",");
+            std::strcat(header, profile_phase_name(profile_phase(i)));
+            std::strcat(header, "_us");
+        }
+        std::strcat(header, ",total_us,drew");
+        /// the control thread publishes under this lock , the queue takes one producer at a time
+        std::lock_guard<std::mutex> guard(main_timers_lock);
+        main_checkpoint.trace("%s", header);
+    }
+    main_startup.mark("shapes");
+    bool first_frame = true;
+
+    /// we sleep inside RGFW until an event comes or the shown digits are about to change
+    /// paused timer have nothing to change so it just wait for next event
+    t_str_buf last_frame_str {};
+    bool need_redraw = true;
+    int wait_ms = RGFW_eventNoWait;
+    std::array<lap_str_buf, lap_rows> lap_strs {};
+    std::array<size_t, lap_rows> lap_lens {};
+    size_t lap_scroll = 0;
+    while(RGFW_window_shouldClose(RGFW_window_obj) == false)
+    {
+        RGFW_event RGFW_event_obj;
+
+        if(profiler.enabled)
+        {
+            profiler.next_turn(drew_frame, pacing_now_ns());
+            if(trace_path != nullptr && profiler.turns != 0)
+            {
+                const int64_t *phase_ns = profiler.last;
+                int64_t total_ns = 0;
+                for (size_t i = 0; i < profile_phase_count; i++)
+                {
+                    total_ns += phase_ns[i];
+                }
+                std::lock_guard<std::mutex> guard(main_timers_lock);
+                main_checkpoint.trace("%llu,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%d", (unsigned long long)profiler.turns, (long long)profiler.last_start_ns,
+                    (long long)phase_ns[0] / 1000, (long long)phase_ns[1] / 1000, (long long)phase_ns[2] / 1000, (long long)phase_ns[3] / 1000,
+                    (long long)phase_ns[4] / 1000, (long long)phase_ns[5] / 1000, (long long)phase_ns[6] / 1000, (long long)total_ns / 1000, int(profiler.last_drew));
+            }
+        }
+        drew_frame = false;
+
+        {
+            scoped_phase timing(profiler, profile_phase::wait);
+            RGFW_waitForEvent(wait_ms);
+        }
+        if(control_changed.exchange(false))
+        {
+            need_redraw = true;
+        }
+        scoped_phase events_timing(profiler, profile_phase::events);
+        std::unique_lock<std::mutex> timers_guard(main_timers_lock);
+        if(alarms.take_due())
+        {
+            size_t expired[stopwatch_set::max_timers];
+            size_t expired_count = alarms.expire(main_timers, clc_clock::now(), expired);
+            for (size_t i = 0; i < expired_count; i++)
+            {
+                publish_timer(expired[i], journal_event::stop);
+                main_checkpoint.log("clc. massage [alert] : %s is up", main_timers.names[expired[i]].c_str());
+                need_redraw = true;
+            }
+        }
+        while(RGFW_window_checkEvent(RGFW_window_obj, &RGFW_event_obj))
+        {
+            /// any event (expose , focus , keys) can change the window so draw again
+            need_redraw = true;
+            if(RGFW_event_obj.type == RGFW_focusIn || RGFW_event_obj.type == RGFW_focusOut)
+            {
+                keys.set_focused(RGFW_event_obj.type == RGFW_focusIn);
+            }
+//          space
+            if(RGFW_event_obj.type == RGFW_keyPressed && RGFW_event_obj.button.value == RGFW_keySpace)    
+            {
+                /// stop and start timer proc
+                stopwatch active = main_timers.get(main_timers.active);
+                clc_clock::time_point pressed = press_time(XK_space);
+                /// a start timed by the loop and a quick stop timed by the server could cross
+                active.toggle(active.running ? std::max(pressed, active.start_time) : pressed);
+                main_timers.put(main_timers.active, active);
+                publish_timer(main_timers.active, active.running ? journal_event::start : journal_event::stop);
+            }
+//          r
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyR)
+            {
+                stopwatch active = main_timers.get(main_timers.active);
+                active.reset(clc_clock::now());
+                main_timers.put(main_timers.active, active);
+                publish_timer(main_timers.active, journal_event::reset);
+                main_laps.reset_timer(main_timers.active);
+            }
+//          l
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyL && main_timers.running[main_timers.active])
+            {
+                /// only the ring is touched here , the checkpointer gets laps in batches below
+                clc_clock::time_point now = std::max(press_time(XK_l), main_timers.get(main_timers.active).start_time);
+                main_laps.push(main_timers.active, main_timers.elapsed_ns(main_timers.active, now), now.time_since_epoch().count());
+                lap_scroll = 0;
+            }
+//          up , down : scroll the lap list
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyDown)
+            {
+                lap_scroll++;
+            }
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyUp && lap_scroll != 0)
+            {
+                lap_scroll--;
+            }
+//          tab , n , 1-9 : pick which timer the keys and the big digits are about
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyTab)
+            {
+                main_timers.active = (main_timers.active + 1) % main_timers.size();
+            }
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyN)
+            {
+                size_t index = main_timers.add("timer " + std::to_string(main_timers.size() + 1));
+                if(index != stopwatch_set::max_timers)
+                {
+                    main_timers.active = index;
+                    publish_timer(index, journal_event::checkpoint);
+                }
+            }
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value >= RGFW_key1 && RGFW_event_obj.button.value <= RGFW_key9)
+            {
+                size_t index = size_t(RGFW_event_obj.button.value - RGFW_key1);
+                if(index < main_timers.size())
+                {
+                    main_timers.active = index;
+                }
+            }
+//          f3
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyF3)
+            {
+                show_frame_stats = !show_frame_stats;
+                frame_times.clear();
+                frame_stats_at_ns = 0;
+            }
+//          p
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyP)
+            {
+                show_profile = !show_profile;
+                profiler.enabled = show_profile || trace_path != nullptr;
+                profile_at_ns = 0;
+            }
+//          q
+            if (RGFW_event_obj.type == RGFW_keyPressed &&  RGFW_event_obj.button.value == RGFW_keyQ)
+            {
+                timers_guard.unlock();
+                alarms.close();
+                save_time();
+                return 0;
+            }
+
+        }
+        /// keys and control commands both land before here
+        alarms.arm(main_timers);
+        events_timing.done();
+
+        scoped_phase format_timing(profiler, profile_phase::format);
+        clc_clock::time_point frame_now = clc_clock::now();
+        int64_t rus_time_ns = main_timers.shown_ns(main_timers.active, frame_now);
+        size_t t_str_len = t_str_fucn(rus_time_ns, t_str);
+        /// late latch reads the clock again right before drawing , off the lock
+        const stopwatch latched = main_timers.get(main_timers.active);
+
+        const bool active_running = main_timers.running[main_timers.active] != 0;
+        int content_ms = active_running ? next_redraw_ms(rus_time_ns, latched.counts_down()) : RGFW_eventWaitNext;
+        int64_t pace_now_ns = pacing_now_ns();
+        if(pacer.tick_due(active_running, pace_now_ns))
+        {
+            need_redraw = true;
+        }
+        /// the wait with no frame owed (next digit change , paused tick , laps below) . a turn
+        /// that draws and the unchanged string skip keep it , the fixed deadline skip asks again
+        wait_ms = pacer.wait_ms(content_ms, false, pace_now_ns);
+
+        if(main_laps.flush_due(frame_now.time_since_epoch().count(), checkpointer::lap_batch))
+        {
+            main_checkpoint.publish_laps(main_laps);
+        }
+        if(main_laps.pending() != 0)
+        {
+            /// a lone lap on a paused screen still has to reach the checkpointer
+            constexpr int lap_wait_ms = int(lap_ring::flush_after_ns / 1000000);
+            wait_ms = wait_ms < 0 ? lap_wait_ms : std::min(wait_ms, lap_wait_ms);
+        }
+
+        /// laps only change on key events and control commands , so the list is rebuilt only then
+        if(need_redraw)
+        {
+            const lap_entry *visible[lap_rows];
+            size_t found = main_laps.newest_of(main_timers.active, lap_scroll, visible, lap_rows);
+            if(found == 0 && lap_scroll != 0)
+            {
+                /// scrolled past the oldest one
+                lap_scroll--;
+                found = main_laps.newest_of(main_timers.active, lap_scroll, visible, lap_rows);
+            }
+            for (size_t i = 0; i < lap_rows; i++)
+            {
+                lap_lens[i] = i < found ? lap_str_fucn(visible[i]->number, visible[i]->split_ns, lap_strs[i]) : 0;
+            }
+        }
+
+        /// "2/3" in the corner once there is more than one timer , the atlas only has digits so no names here
+        char which_str[16] {};
+        size_t which_len = 0;
+        if(main_timers.size() > 1)
+        {
+            which_len = size_t(snprintf(which_str, sizeof(which_str), "%zu/%zu", main_timers.active + 1, main_timers.size()));
+        }
+        /// everything below draws from the copies above
+        timers_guard.unlock();
+        format_timing.done();
+
+        /// same string as the frame on screen , nothing to do until the wait set above
+        if(!need_redraw && t_str == last_frame_str)
+        {
+            continue;
+        }
+        /// fixed fps : a frame is owed but its deadline is still ahead
+        if(!pacer.ready(pace_now_ns))
+        {
+            wait_ms = pacer.wait_ms(content_ms, true, pace_now_ns);
+            continue;
+        }
+        {
+            scoped_phase timing(profiler, profile_phase::pace);
+            pacer.wait_for_deadline();
+        }
+
+        /// 4 overlay updates a second are plenty to read and don't disturb what they measure
+        if(show_frame_stats && pace_now_ns - frame_stats_at_ns >= 250000000)
+        {
+            double seconds = frame_stats_at_ns == 0 ? 0.0 : double(pace_now_ns - frame_stats_at_ns) / 1e9;
+            double fps = seconds > 0.0 ? double(frame_times.frames - frame_stats_frames) / seconds : 0.0;
+            frame_stats_len[0] = size_t(snprintf(frame_stats_str[0], sizeof(frame_stats_str[0]), "%.1f", fps));
+            frame_stats_len[1] = size_t(snprintf(frame_stats_str[1], sizeof(frame_stats_str[1]), "%.1f/%.1f", double(frame_times.percentile_ns(0.5)) / 1e6, double(frame_times.percentile_ns(0.99)) / 1e6));
+            frame_stats_at_ns = pace_now_ns;
+            frame_stats_frames = frame_times.frames;
+
+            float highest = float(std::max<uint32_t>(frame_times.max_bucket(), 1));
+            for (size_t i = 0; use_shapes && i < frame_bars.size(); i++)
+            {
+                float height = 120.0f * float(frame_times.buckets[i]) / highest;
+                shapes.set_rect(frame_bars[i], 16.0f + 12.0f * float(i), 590.0f - height, 10.0f, height);
+            }
+        }
+        if(show_profile && pace_now_ns - profile_at_ns >= 250000000)
+        {
+            frame_profiler::summary summary = profiler.take_summary();
+            for (size_t i = 0; i < profile_rows; i++)
+            {
+                bool cpu_row = i == profile_phase_count;
+                double value = cpu_row ? summary.cpu_percent : summary.avg_ms[i];
+                profile_len[i] = cpu_row ? size_t(snprintf(profile_str[i], sizeof(profile_str[i]), "%.1f", value))
+                                         : size_t(snprintf(profile_str[i], sizeof(profile_str[i]), "%.2f/%.2f", value, summary.max_ms[i]));
+                float width = float(std::min(value / (cpu_row ? 100.0 : 16.7), 1.0)) * 120.0f;
+                if(use_shapes)
+                {
+                    shapes.set_rect(profile_bars[i], 440.0f, 256.0f + 22.0f * float(i), width, 14.0f);
+                }
+            }
+            profile_at_ns = pace_now_ns;
+        }
+
+        /// the pacing sleep and the overlays sit between the first read and the draw , so the
+        /// digits are read again here . a new string only changes the dynamic line , the skip
+        /// above already decided this frame gets drawn
+        int64_t latch_ns = pacing_now_ns();
+        if(latch != latch_mode::off && active_running)
+        {
+            clc_clock::time_point latch_now = clc_clock::now();
+            if(latch == latch_mode::predict)
+            {
+                latch_now += duration_ns(predictor.lead_ns(latch_ns));
+            }
+            rus_time_ns = latched.shown(latch_now).count();
+            t_str_len = t_str_fucn(rus_time_ns, t_str);
+        }
+
+//      graphic interface    
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        /// a countdown that reached zero turns the time red until it's reset or started again
+        const float text_gb = latched.finished() ? 0.3f : 1.0f;
+
+        scoped_phase text_timing(profiler, profile_phase::text);
+        if(use_text_layer)
+        {
+            main_text.set_dynamic(0, t_str.data(), t_str_len, 170.0f, 350.0f);
+            main_text.set_dynamic(1, which_str, which_len, 560.0f, 100.0f);
+            for (size_t i = 0; i < lap_rows; i++)
+            {
+                main_text.set_dynamic(2 + i, lap_strs[i].data(), lap_lens[i], 170.0f, 430.0f + 45.0f * float(i), 0.3f);
+            }
+            /// fps , then p50/p99 frame time in ms
+            for (size_t i = 0; i < 2; i++)
+            {
+                main_text.set_dynamic(2 + lap_rows + i, frame_stats_str[i], show_frame_stats ? frame_stats_len[i] : 0, 600.0f, 180.0f + 45.0f * float(i), 0.3f);
+            }
+            for (size_t i = 0; i < profile_rows; i++)
+            {
+                main_text.set_dynamic(4 + lap_rows + i, profile_str[i], show_profile ? profile_len[i] : 0, 570.0f, 270.0f + 22.0f * float(i), 0.15f);
+            }
+            /// only the time goes red , the label and the overlays keep white . any other frame stays one draw call
+            if(latched.finished())
+            {
+                main_text.set_dynamic_color(0, 1.0f, text_gb, text_gb, 1.0f);
+            }
+            else
+            {
+                main_text.clear_dynamic_color(0);
+            }
+            main_text.draw(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        else
+        {
+            glyph_renderer_draw_text(&renderer, t_str.data(),170.0f, 350.0f, 1.0f, 1.0f, text_gb, text_gb, GLYPH_EFFECT_NONE);
+            glyph_renderer_draw_text(&renderer,"clc.", 10, 100, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+            if(which_len != 0)
+            {
+                glyph_renderer_draw_text(&renderer, which_str, 560.0f, 100.0f, 1.0f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+            }
+            for (size_t i = 0; i < lap_rows && lap_lens[i] != 0; i++)
+            {
+                glyph_renderer_draw_text(&renderer, lap_strs[i].data(), 170.0f, 430.0f + 45.0f * float(i), 0.3f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+            }
+            for (size_t i = 0; show_frame_stats && i < 2; i++)
+            {
+                glyph_renderer_draw_text(&renderer, frame_stats_str[i], 600.0f, 180.0f + 45.0f * float(i), 0.3f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+            }
+            for (size_t i = 0; show_profile && i < profile_rows; i++)
+            {
+                glyph_renderer_draw_text(&renderer, profile_str[i], 570.0f, 270.0f + 22.0f * float(i), 0.15f, 1.0f, 1.0f, 1.0f, GLYPH_EFFECT_NONE);
+            }
+        }
+        text_timing.done();
+
+        scoped_phase shapes_timing(profiler, profile_phase::shapes);
+        if(use_shapes)
+        {
+            shapes.draw(dot_circle, 1.0f, 1.0f, 1.0f, 1.0f);
+            for (size_t i = 0; show_frame_stats && i < frame_bars.size(); i++)
+            {
+                shapes.draw(frame_bars[i], 0.3f, 0.8f, 0.4f, 0.6f);
+            }
+            for (size_t i = 0; show_profile && i < profile_rows; i++)
+            {
+                shapes.draw(profile_bars[i], profile_colors[i][0], profile_colors[i][1], profile_colors[i][2], 0.8f);
+            }
+        }
+        shapes_timing.done();
+        int64_t swap_call_ns = pacing_now_ns();
+        {
+            scoped_phase timing(profiler, profile_phase::swap);
+            RGFW_window_swapBuffers_OpenGL(RGFW_window_obj);
+        }
+        drew_frame = true;
+        int64_t swap_ns = pacing_now_ns();
+        if(latch == latch_mode::predict)
+        {
+            predictor.frame_swapped(latch_ns, swap_call_ns, swap_ns);
+        }
+        frame_times.record(swap_ns);
+        pacer.frame_done(swap_ns);
+        if(first_frame)
+        {
+            first_frame = false;
+            main_startup.mark("first swap");
+            main_startup.report();
+            if(exit_after_first_frame)
+            {
+                break;
+            }
+        }
+
+        last_frame_str = t_str;
+        need_redraw = false;
+    }
+    main_control.stop();
+    shapes.destroy();
+    main_text.destroy();
+    RGFW_window_close(RGFW_window_obj);
+
+    return 0;
+}
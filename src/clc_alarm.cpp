@@ -0,0 +1,194 @@
+#include "../include/clc_alarm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace
+{
+    int64_t read_ns(int clock)
+    {
+        timespec now;
+        clock_gettime(clock, &now);
+        return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+}
+
+bool parse_countdown(const char *text , duration_ns &out)
+{
+    char *end;
+    double value = std::strtod(text, &end);
+    double unit_ns = 1e9;
+    if(*end == 'm')
+    {
+        unit_ns = 60e9;
+        end++;
+    }
+    else if(*end == 'h')
+    {
+        unit_ns = 3600e9;
+        end++;
+    }
+    else if(*end == 's')
+    {
+        end++;
+    }
+    /// a year is plenty , and keeps the ns far from int64 overflow
+    double ns = value * unit_ns;
+    if(end == text || *end != '\0' || !(ns >= 1.0) || ns > 365.0 * 86400e9)
+    {
+        return false;
+    }
+    out = duration_ns(int64_t(ns));
+    return true;
+}
+
+bool alarm_timer::open(wake_fn wake_callback , void *ctx)
+{
+    timer_clock = current_suspend_policy() == suspend_policy::count ? CLOCK_BOOTTIME : CLOCK_MONOTONIC;
+    timer_fd = timerfd_create(timer_clock, TFD_CLOEXEC | TFD_NONBLOCK);
+    if(timer_fd < 0)
+    {
+        printf("clc. massage [error] : timerfd_create failed , countdowns only stop when something else wakes clc\n");
+        return false;
+    }
+    armed_ns = 0;
+    if(wake_callback == nullptr)
+    {
+        return true;
+    }
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(stop_fd < 0)
+    {
+        close();
+        return false;
+    }
+    wake = wake_callback;
+    wake_ctx = ctx;
+    waiter = std::thread(&alarm_timer::run, this);
+    return true;
+}
+
+void alarm_timer::close()
+{
+    if(waiter.joinable())
+    {
+        uint64_t one = 1;
+        ssize_t ignored = write(stop_fd, &one, sizeof(one));
+        (void)ignored;
+        waiter.join();
+    }
+    if(stop_fd >= 0)
+    {
+        ::close(stop_fd);
+        stop_fd = -1;
+    }
+    if(timer_fd >= 0)
+    {
+        ::close(timer_fd);
+        timer_fd = -1;
+    }
+}
+
+void alarm_timer::run()
+{
+    pollfd fds[2] {{timer_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+    while(true)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            continue;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            return;
+        }
+        uint64_t expirations;
+        /// arm() can move the deadline between poll and here , then there's nothing to read
+        if(read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+        {
+            due = true;
+            wake(wake_ctx);
+        }
+    }
+}
+
+void alarm_timer::arm(const stopwatch_set &timers)
+{
+    if(timer_fd < 0)
+    {
+        return;
+    }
+    int64_t deadline_ns = 0;
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if(timers.running[i] && timers.target_ns[i] != 0)
+        {
+            int64_t at = timers.start_ns[i] + timers.target_ns[i] - timers.saved_ns[i];
+            deadline_ns = deadline_ns == 0 ? at : std::min(deadline_ns, at);
+        }
+    }
+    if(deadline_ns == armed_ns)
+    {
+        return;
+    }
+    itimerspec when {};
+    if(deadline_ns != 0)
+    {
+        /// steady + skip reads CLOCK_MONOTONIC itself , anything else is moved over by the
+        /// difference of two reads (raw and tsc drift from it by ppm , expire() checks again)
+        int64_t timer_ns = clock_is_monotonic() ? deadline_ns : read_ns(timer_clock) + (deadline_ns - clock_now_ns());
+        /// 0 would disarm it , a deadline already gone fires right away
+        timer_ns = std::max<int64_t>(timer_ns, 1);
+        when.it_value.tv_sec = timer_ns / 1000000000;
+        when.it_value.tv_nsec = timer_ns % 1000000000;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &when, nullptr);
+    armed_ns = deadline_ns;
+}
+
+bool alarm_timer::take_due()
+{
+    bool fired;
+    if(waiter.joinable())
+    {
+        fired = due.exchange(false);
+    }
+    else
+    {
+        uint64_t expirations;
+        fired = timer_fd >= 0 && read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations);
+    }
+    if(fired)
+    {
+        /// the timerfd is spent , the next arm() sets it again even for the same deadline
+        armed_ns = 0;
+    }
+    return fired;
+}
+
+size_t alarm_timer::expire(stopwatch_set &timers , clc_clock::time_point now , size_t *out)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if(!timers.running[i] || timers.target_ns[i] == 0)
+        {
+            continue;
+        }
+        clc_clock::time_point deadline(duration_ns(timers.start_ns[i] + timers.target_ns[i] - timers.saved_ns[i]));
+        if(deadline <= now)
+        {
+            stopwatch state = timers.get(i);
+            state.stop(deadline);
+            timers.put(i, state);
+            out[count++] = i;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,273 @@
+#include "../include/clc_clock.h"
+
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define CLC_HAVE_TSC 1
+#endif
+
+namespace
+{
+    int64_t timespec_ns(clockid_t id)
+    {
+        timespec ts;
+        clock_gettime(id, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    int64_t steady_now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t monotonic_raw_now()
+    {
+        return timespec_ns(CLOCK_MONOTONIC_RAW);
+    }
+
+    int64_t monotonic_coarse_now()
+    {
+        return timespec_ns(CLOCK_MONOTONIC_COARSE);
+    }
+
+    int64_t boottime_now()
+    {
+        return timespec_ns(CLOCK_BOOTTIME);
+    }
+
+    int64_t suspended_now()
+    {
+        int64_t monotonic_ns = timespec_ns(CLOCK_MONOTONIC);
+        int64_t suspended_ns = timespec_ns(CLOCK_BOOTTIME) - monotonic_ns;
+        return suspended_ns > 0 ? suspended_ns : 0;
+    }
+
+#ifdef CLC_HAVE_TSC
+    /// ns = base_ns + (tsc - base_tsc) * tsc_mult >> 32
+    uint64_t tsc_base = 0;
+    int64_t tsc_base_ns = 0;
+    uint64_t tsc_mult = 0;
+
+    int64_t tsc_now()
+    {
+        /// signed : a core whose tsc is a little behind the calibrating one (cross socket , vm)
+        /// reads below tsc_base , unsigned that wraps to ~2^64 ticks and jumps centuries ahead
+        int64_t delta = int64_t(__rdtsc() - tsc_base);
+        return tsc_base_ns + int64_t((__int128)delta * int64_t(tsc_mult) >> 32);
+    }
+
+    bool tsc_is_invariant()
+    {
+        unsigned eax, ebx, ecx, edx;
+        if(__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+        {
+            return false;
+        }
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+    }
+
+    bool calibrate_tsc()
+    {
+        if(!tsc_is_invariant())
+        {
+            return false;
+        }
+        int64_t start_ns = monotonic_raw_now();
+        uint64_t start_tsc = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        int64_t end_ns = monotonic_raw_now();
+        uint64_t end_tsc = __rdtsc();
+
+        if(end_tsc <= start_tsc || end_ns <= start_ns)
+        {
+            return false;
+        }
+        tsc_mult = uint64_t(((unsigned __int128)(end_ns - start_ns) << 32) / (end_tsc - start_tsc));
+        tsc_base = end_tsc;
+        tsc_base_ns = end_ns;
+        return true;
+    }
+#endif
+
+    clock_source selected = clock_source::steady;
+    int64_t (*selected_fn)() = steady_now;
+    suspend_policy selected_policy = suspend_policy::skip;
+    const fake_clock *fake = nullptr;
+
+    int64_t fake_now()
+    {
+        return selected_policy == suspend_policy::count ? fake->boottime_ns : fake->monotonic_ns;
+    }
+
+    int64_t fake_suspended()
+    {
+        return fake->boottime_ns - fake->monotonic_ns;
+    }
+
+    /// the one place clock_now_fn and clock_suspended_fn get set
+    void apply_clock()
+    {
+        if(fake != nullptr)
+        {
+            clock_now_fn = fake_now;
+            clock_suspended_fn = fake_suspended;
+            return;
+        }
+        clock_now_fn = selected_policy == suspend_policy::count ? boottime_now : selected_fn;
+        clock_suspended_fn = suspended_now;
+    }
+
+    struct source_entry
+    {
+        clock_source source;
+        const char *name;
+    };
+
+    const source_entry source_names[] {
+        {clock_source::steady, "steady"},
+        {clock_source::monotonic_raw, "raw"},
+        {clock_source::monotonic_coarse, "coarse"},
+        {clock_source::tsc, "tsc"},
+    };
+
+    struct policy_entry
+    {
+        suspend_policy policy;
+        const char *name;
+    };
+
+    const policy_entry policy_names[] {
+        {suspend_policy::skip, "skip"},
+        {suspend_policy::count, "count"},
+    };
+}
+
+int64_t (*clock_now_fn)() = steady_now;
+int64_t (*clock_suspended_fn)() = suspended_now;
+
+const char *clock_source_name(clock_source source)
+{
+    for (const source_entry &entry : source_names)
+    {
+        if(entry.source == source)
+        {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+bool clock_source_from_name(const char *name, clock_source &out)
+{
+    for (const source_entry &entry : source_names)
+    {
+        if(std::strcmp(entry.name, name) == 0)
+        {
+            out = entry.source;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool select_clock_source(clock_source source)
+{
+    if(selected_policy == suspend_policy::count && source != clock_source::steady)
+    {
+        return false;
+    }
+    switch (source)
+    {
+    case clock_source::steady:
+        selected_fn = steady_now;
+        break;
+    case clock_source::monotonic_raw:
+        selected_fn = monotonic_raw_now;
+        break;
+    case clock_source::monotonic_coarse:
+        selected_fn = monotonic_coarse_now;
+        break;
+    case clock_source::tsc:
+#ifdef CLC_HAVE_TSC
+        if(!calibrate_tsc())
+        {
+            return false;
+        }
+        selected_fn = tsc_now;
+        break;
+#else
+        return false;
+#endif
+    }
+    selected = source;
+    apply_clock();
+    return true;
+}
+
+clock_source current_clock_source()
+{
+    return selected;
+}
+
+const char *suspend_policy_name(suspend_policy policy)
+{
+    for (const policy_entry &entry : policy_names)
+    {
+        if(entry.policy == policy)
+        {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+bool suspend_policy_from_name(const char *name, suspend_policy &out)
+{
+    for (const policy_entry &entry : policy_names)
+    {
+        if(std::strcmp(entry.name, name) == 0)
+        {
+            out = entry.policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool select_suspend_policy(suspend_policy policy)
+{
+    if(policy == suspend_policy::count && selected != clock_source::steady)
+    {
+        return false;
+    }
+    selected_policy = policy;
+    apply_clock();
+    return true;
+}
+
+suspend_policy current_suspend_policy()
+{
+    return selected_policy;
+}
+
+bool clock_is_monotonic()
+{
+    return fake == nullptr && selected == clock_source::steady && selected_policy == suspend_policy::skip;
+}
+
+void clock_install_fake(const fake_clock *clock)
+{
+    fake = clock;
+    apply_clock();
+}
+
+void clock_uninstall_fake()
+{
+    fake = nullptr;
+    apply_clock();
+}
@@ -0,0 +1,518 @@
+#include "../include/clc_control.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    /// epoll tags , clients use their slot index
+    constexpr uint64_t listen_tag = ~uint64_t(0);
+    constexpr uint64_t stop_tag = ~uint64_t(0) - 1;
+
+    bool make_address(const fs::path &path , sockaddr_un &address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if(path.native().size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.native().size());
+        return true;
+    }
+
+    /// reads an optional number after the command , `fallback` when there is none
+    bool parse_index(const char *begin , const char *end , size_t fallback , size_t &out)
+    {
+        while(begin < end && *begin == ' ')
+        {
+            begin++;
+        }
+        if(begin == end)
+        {
+            out = fallback;
+            return true;
+        }
+        auto result = std::from_chars(begin, end, out);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    void append_number(std::string &out , int64_t value)
+    {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, result.ptr);
+    }
+}
+
+bool control_server::start(const fs::path &path , stopwatch_set &timer_set , lap_ring &lap_set , checkpointer &checkpoint , std::mutex &lock , wake_fn wake_callback , void *ctx)
+{
+    socket_path = path;
+    timers = &timer_set;
+    laps = &lap_set;
+    saver = &checkpoint;
+    state_lock = &lock;
+    wake = wake_callback;
+    wake_ctx = ctx;
+
+    sockaddr_un address;
+    if(!make_address(path, address))
+    {
+        return false;
+    }
+
+    /// something answering there is another clc , a dead socket file is just left over
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(probe >= 0)
+    {
+        bool taken = connect(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        close(probe);
+        if(taken)
+        {
+            return false;
+        }
+    }
+    unlink(path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(listen_fd < 0 || epoll_fd < 0 || stop_fd < 0
+        || bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || chmod(path.c_str(), 0600) != 0
+        || listen(listen_fd, 64) != 0)
+    {
+        stop();
+        return false;
+    }
+
+    epoll_event listen_event {};
+    listen_event.events = EPOLLIN;
+    listen_event.data.u64 = listen_tag;
+    epoll_event stop_event {};
+    stop_event.events = EPOLLIN;
+    stop_event.data.u64 = stop_tag;
+    if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event) != 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &stop_event) != 0)
+    {
+        stop();
+        return false;
+    }
+
+    worker = std::thread(&control_server::run, this);
+    return true;
+}
+
+void control_server::stop()
+{
+    if(worker.joinable())
+    {
+        uint64_t one = 1;
+        ssize_t ignored = write(stop_fd, &one, sizeof(one));
+        (void)ignored;
+        worker.join();
+    }
+    for (client &c : clients)
+    {
+        if(c.fd >= 0)
+        {
+            close_client(c);
+        }
+    }
+    if(listen_fd >= 0)
+    {
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path.c_str());
+    }
+    if(epoll_fd >= 0)
+    {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+    if(stop_fd >= 0)
+    {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+}
+
+void control_server::run()
+{
+    epoll_event events[32];
+    while(true)
+    {
+        int count = epoll_wait(epoll_fd, events, 32, -1);
+        if(count < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+
+        bool changed = false;
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t tag = events[i].data.u64;
+            if(tag == stop_tag)
+            {
+                return;
+            }
+            if(tag == listen_tag)
+            {
+                accept_clients();
+                continue;
+            }
+
+            client &c = clients[tag];
+            if(c.fd < 0)
+            {
+                continue;
+            }
+            bool open = true;
+            if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                /// lines that came right before eof still get run and answered
+                open = read_client(c);
+            }
+            /// run what's buffered up to the reply cap , keep going while the socket takes it all
+            while(open)
+            {
+                changed = execute_lines(c) || changed;
+                if(c.out.empty())
+                {
+                    break;
+                }
+                open = write_client(c);
+                if(!c.out.empty())
+                {
+                    break;
+                }
+            }
+            if(open && c.eof && c.out.empty())
+            {
+                /// nothing more will come and everything got answered
+                open = false;
+            }
+            if(!open)
+            {
+                if(c.fd >= 0)
+                {
+                    close_client(c);
+                }
+                continue;
+            }
+            watch_client(c);
+        }
+
+        /// one wake per epoll round , not per command
+        if(changed && wake != nullptr)
+        {
+            wake(wake_ctx);
+        }
+    }
+}
+
+void control_server::accept_clients()
+{
+    while(true)
+    {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0)
+        {
+            return;
+        }
+
+        size_t slot = 0;
+        while(slot < max_clients && clients[slot].fd >= 0)
+        {
+            slot++;
+        }
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.u64 = slot;
+        if(slot == max_clients || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        clients[slot].fd = fd;
+        clients[slot].in.clear();
+        clients[slot].out.clear();
+        clients[slot].events = EPOLLIN;
+        clients[slot].eof = false;
+    }
+}
+
+bool control_server::read_client(client &c)
+{
+    char buf[16384];
+    /// a client writing as fast as this thread reads would keep the loop going forever ,
+    /// the rest waits in the socket until these lines ran
+    while(c.in.size() < max_pending_out)
+    {
+        ssize_t result = read(c.fd, buf, sizeof(buf));
+        if(result > 0)
+        {
+            c.in.append(buf, size_t(result));
+            if(size_t(result) < sizeof(buf))
+            {
+                return true;
+            }
+            continue;
+        }
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return true;
+        }
+        if(result == 0)
+        {
+            /// the caller closes once it answered what came before it
+            c.eof = true;
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool control_server::write_client(client &c)
+{
+    size_t written = 0;
+    while(written < c.out.size())
+    {
+        ssize_t result = send(c.fd, c.out.data() + written, c.out.size() - written, MSG_NOSIGNAL);
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if(result <= 0)
+        {
+            close_client(c);
+            return false;
+        }
+        written += size_t(result);
+    }
+    c.out.erase(0, written);
+    return true;
+}
+
+void control_server::watch_client(client &c)
+{
+    /// only ask for EPOLLOUT while the socket is backed up , and stop reading a client that
+    /// doesn't read its replies
+    uint32_t events = 0;
+    if(!c.eof && c.out.size() < max_pending_out)
+    {
+        events |= EPOLLIN;
+    }
+    if(!c.out.empty())
+    {
+        events |= EPOLLOUT;
+    }
+    if(events != c.events)
+    {
+        epoll_event event {};
+        event.events = events;
+        event.data.u64 = uint64_t(&c - clients.data());
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c.fd, &event);
+        c.events = events;
+    }
+}
+
+void control_server::close_client(client &c)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    c.fd = -1;
+    c.in.clear();
+    c.out.clear();
+    c.events = 0;
+    c.eof = false;
+}
+
+bool control_server::execute_lines(client &c)
+{
+    bool changed = false;
+    bool partial = false;
+    size_t begin = 0;
+    /// the whole batch runs under one lock
+    std::lock_guard<std::mutex> guard(*state_lock);
+    while(c.out.size() < max_pending_out)
+    {
+        size_t end = c.in.find('\n', begin);
+        if(end == std::string::npos)
+        {
+            partial = true;
+            break;
+        }
+        size_t len = end - begin;
+        if(len != 0 && c.in[begin + len - 1] == '\r')
+        {
+            len--;
+        }
+        changed = execute(c.in.data() + begin, len, c.out) || changed;
+        begin = end + 1;
+    }
+    c.in.erase(0, begin);
+    if(partial && c.in.size() > max_line)
+    {
+        /// no newline in sight , nobody sends lines that long on purpose
+        c.out += "err line too long\n";
+        c.in.clear();
+    }
+    return changed;
+}
+
+void control_server::reply_timer(size_t index , std::string &reply)
+{
+    reply += "ok ";
+    append_number(reply, int64_t(index));
+    reply += timers->running[index] ? " 1 " : " 0 ";
+    append_number(reply, timers->elapsed_ns(index, clc_clock::now()));
+    reply += ' ';
+    append_number(reply, int64_t(laps->count[index]));
+    reply += '\n';
+}
+
+bool control_server::execute(const char *line , size_t len , std::string &reply)
+{
+    const char *end = line + len;
+    const char *word_end = static_cast<const char *>(std::memchr(line, ' ', len));
+    if(word_end == nullptr)
+    {
+        word_end = end;
+    }
+    const std::string_view word(line, size_t(word_end - line));
+
+    if(word == "count")
+    {
+        reply += "ok ";
+        append_number(reply, int64_t(timers->size()));
+        reply += '\n';
+        return false;
+    }
+    if(word == "new")
+    {
+        std::string name(word_end < end ? word_end + 1 : end, end);
+        if(name.empty())
+        {
+            name = "timer " + std::to_string(timers->size() + 1);
+        }
+        size_t index = timers->add(std::move(name));
+        if(index == stopwatch_set::max_timers)
+        {
+            reply += "err too many timers\n";
+            return false;
+        }
+        saver->publish(index, timers->get(index), journal_event::checkpoint, timers->names[index].c_str());
+        reply += "ok ";
+        append_number(reply, int64_t(index));
+        reply += '\n';
+        return true;
+    }
+
+    if(word == "countdown")
+    {
+        const char *length_begin = word_end < end ? word_end + 1 : end;
+        const char *length_end = static_cast<const char *>(std::memchr(length_begin, ' ', size_t(end - length_begin)));
+        if(length_end == nullptr)
+        {
+            length_end = end;
+        }
+        std::string length(length_begin, length_end);
+        stopwatch state;
+        if(!parse_countdown(length.c_str(), state.target))
+        {
+            reply += "err bad length\n";
+            return false;
+        }
+        std::string name(length_end < end ? length_end + 1 : end, end);
+        if(name.empty())
+        {
+            name = "countdown " + length;
+        }
+        size_t index = timers->add(std::move(name));
+        if(index == stopwatch_set::max_timers)
+        {
+            reply += "err too many timers\n";
+            return false;
+        }
+        timers->put(index, state);
+        saver->publish(index, state, journal_event::checkpoint, timers->names[index].c_str());
+        reply += "ok ";
+        append_number(reply, int64_t(index));
+        reply += '\n';
+        return true;
+    }
+
+    size_t index;
+    if(!parse_index(word_end, end, timers->active, index) || index >= timers->size())
+    {
+        reply += "err bad timer\n";
+        return false;
+    }
+    clc_clock::time_point now = clc_clock::now();
+    stopwatch state = timers->get(index);
+    bool changed = false;
+
+    if(word == "query")
+    {
+    }
+    else if(word == "start" || word == "stop" || word == "toggle")
+    {
+        bool want_running = word == "start" ? true : word == "stop" ? false : !state.running;
+        if(state.running != want_running)
+        {
+            state.toggle(now);
+            timers->put(index, state);
+            saver->publish(index, state, state.running ? journal_event::start : journal_event::stop, timers->names[index].c_str());
+            changed = true;
+        }
+    }
+    else if(word == "reset")
+    {
+        state.reset(now);
+        timers->put(index, state);
+        saver->publish(index, state, journal_event::reset, timers->names[index].c_str());
+        laps->reset_timer(index);
+        changed = true;
+    }
+    else if(word == "lap")
+    {
+        if(!state.running)
+        {
+            reply += "err not running\n";
+            return false;
+        }
+        laps->push(index, state.elapsed(now).count(), now.time_since_epoch().count());
+        changed = true;
+    }
+    else
+    {
+        reply += "err unknown command\n";
+        return false;
+    }
+    reply_timer(index, reply);
+    return changed;
+}
@@ -0,0 +1,280 @@
+/// clc_ctl : tiny client for ~/.clc/control (clc --control)
+///
+///   clc_ctl start            sends one command , prints the reply , exit 1 on "err"
+///   clc_ctl --bench [--clients C] [--commands N] [--pipeline P] [--command "query"]
+///                            load generator : C connections , each sends N commands
+///                            P at a time , prints throughput and round trip percentiles
+///   clc_ctl --shm [timer]    reads /dev/shm/clc-<uid> instead of the socket , works without
+///                            --control and never bothers clc
+#include "../include/clc_control.h"
+#include "../include/clc_shm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    int connect_control()
+    {
+        const std::string path = control_socket_path().string();
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if(path.size() >= sizeof(address.sun_path))
+        {
+            return -1;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool send_all(int fd , const char *data , size_t len)
+    {
+        while(len != 0)
+        {
+            ssize_t result = send(fd, data, len, MSG_NOSIGNAL);
+            if(result <= 0)
+            {
+                return false;
+            }
+            data += result;
+            len -= size_t(result);
+        }
+        return true;
+    }
+
+    /// reads until `lines` newlines came in , the replies land in out
+    bool read_lines(int fd , size_t lines , std::string &out)
+    {
+        char buf[16384];
+        out.clear();
+        while(lines != 0)
+        {
+            ssize_t result = read(fd, buf, sizeof(buf));
+            if(result <= 0)
+            {
+                return false;
+            }
+            lines -= size_t(std::count(buf, buf + result, '\n'));
+            out.append(buf, size_t(result));
+        }
+        return true;
+    }
+
+    int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct bench_result
+    {
+        std::vector<int64_t> round_trips; /// ns per pipelined batch
+        size_t errors = 0;
+        bool failed = false;
+    };
+
+    void bench_client(const std::string &command , size_t commands , size_t pipeline , bench_result &result)
+    {
+        int fd = connect_control();
+        if(fd < 0)
+        {
+            result.failed = true;
+            return;
+        }
+        std::string batch;
+        for (size_t i = 0; i < pipeline; i++)
+        {
+            batch += command;
+            batch += '\n';
+        }
+        std::string replies;
+        result.round_trips.reserve(commands / pipeline + 1);
+        for (size_t sent = 0; sent < commands; sent += pipeline)
+        {
+            size_t count = std::min(pipeline, commands - sent);
+            int64_t begin = now_ns();
+            if(!send_all(fd, batch.data(), count * (command.size() + 1)) || !read_lines(fd, count, replies))
+            {
+                result.failed = true;
+                break;
+            }
+            result.round_trips.push_back(now_ns() - begin);
+            for (size_t at = replies.find("err"); at != std::string::npos; at = replies.find("err", at + 3))
+            {
+                result.errors++;
+            }
+        }
+        close(fd);
+    }
+
+    int run_shm(int argc , char **argv)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/clc-%u", unsigned(getuid()));
+        int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        void *memory = fd < 0 ? MAP_FAILED : mmap(nullptr, sizeof(clc_shm_layout), PROT_READ, MAP_SHARED, fd, 0);
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        if(memory == MAP_FAILED)
+        {
+            printf("clc_ctl : no /dev/shm%s (is clc running ?)\n", name);
+            return 1;
+        }
+        const clc_shm_layout *shm = static_cast<const clc_shm_layout *>(memory);
+        if(std::memcmp(shm->magic, clc_shm_magic, sizeof(clc_shm_magic)) != 0)
+        {
+            printf("clc_ctl : /dev/shm%s isn't a clc segment\n", name);
+            return 1;
+        }
+        /// a clc killed by a signal leaves its last state behind , don't report it as running
+        if(!clc_shm_writer_alive(shm))
+        {
+            printf("clc_ctl : the clc that wrote /dev/shm%s (pid %d) isn't running anymore\n", name, int(shm->writer_pid));
+            munmap(memory, sizeof(clc_shm_layout));
+            return 1;
+        }
+
+        size_t first = 0 , last = clc_shm_max_timers;
+        if(argc > 2)
+        {
+            first = std::strtoul(argv[2], nullptr, 10);
+            last = first + 1;
+        }
+        bool any = false;
+        clc_shm_timer timer;
+        clc_shm_status status = clc_shm_status::ok;
+        for (size_t i = first; i < last; i++)
+        {
+            status = clc_shm_read(shm, i, timer);
+            if(status != clc_shm_status::ok)
+            {
+                break;
+            }
+            /// shown is what's left for a countdown , the elapsed time otherwise
+            printf("%zu %u %lld %lld %s\n", i, timer.running, (long long)clc_shm_shown_ns(timer), (long long)timer.target_ns, timer.name);
+            any = true;
+        }
+        munmap(memory, sizeof(clc_shm_layout));
+        if(status == clc_shm_status::busy)
+        {
+            printf("clc_ctl : /dev/shm%s stays mid-write (did its clc die while updating it ?)\n", name);
+            return 1;
+        }
+        return any ? 0 : 1;
+    }
+
+    int run_bench(int argc , char **argv)
+    {
+        size_t clients = 1 , commands = 100000 , pipeline = 1;
+        std::string command = "query";
+        for (int i = 2; i + 1 < argc; i += 2)
+        {
+            if(std::strcmp(argv[i], "--clients") == 0)
+            {
+                clients = std::max<size_t>(1, std::strtoul(argv[i + 1], nullptr, 10));
+            }
+            else if(std::strcmp(argv[i], "--commands") == 0)
+            {
+                commands = std::max<size_t>(1, std::strtoul(argv[i + 1], nullptr, 10));
+            }
+            else if(std::strcmp(argv[i], "--pipeline") == 0)
+            {
+                pipeline = std::max<size_t>(1, std::strtoul(argv[i + 1], nullptr, 10));
+            }
+            else if(std::strcmp(argv[i], "--command") == 0)
+            {
+                command = argv[i + 1];
+            }
+        }
+
+        std::vector<bench_result> results(clients);
+        std::vector<std::thread> threads;
+        int64_t begin = now_ns();
+        for (size_t i = 0; i < clients; i++)
+        {
+            threads.emplace_back(bench_client, std::cref(command), commands, pipeline, std::ref(results[i]));
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = double(now_ns() - begin) / 1e9;
+
+        std::vector<int64_t> all;
+        size_t errors = 0;
+        for (const bench_result &result : results)
+        {
+            if(result.failed)
+            {
+                printf("clc_ctl : a client lost its connection (is clc running with --control ?)\n");
+                return 1;
+            }
+            all.insert(all.end(), result.round_trips.begin(), result.round_trips.end());
+            errors += result.errors;
+        }
+        std::sort(all.begin(), all.end());
+        auto percentile_us = [&](double p) { return all.empty() ? 0.0 : double(all[size_t(p * double(all.size() - 1))]) / 1000.0; };
+
+        size_t total = clients * commands;
+        printf("clc_ctl bench : \"%s\" x %zu , %zu clients , pipeline %zu\n", command.c_str(), total, clients, pipeline);
+        printf("  %.0f commands/s , %zu errors\n", double(total) / seconds, errors);
+        printf("  round trip (one batch) us : p50 %.1f  p99 %.1f  max %.1f\n", percentile_us(0.5), percentile_us(0.99), percentile_us(1.0));
+        return 0;
+    }
+}
+
+int main(int argc , char **argv)
+{
+    if(argc < 2)
+    {
+        printf("usage : clc_ctl <start|stop|toggle|reset|lap|query> [timer] | new [name] | countdown <length> [name] | count\n"
+               "        clc_ctl --bench [--clients C] [--commands N] [--pipeline P] [--command \"query\"]\n"
+               "        clc_ctl --shm [timer]\n");
+        return 2;
+    }
+    if(std::strcmp(argv[1], "--bench") == 0)
+    {
+        return run_bench(argc, argv);
+    }
+    if(std::strcmp(argv[1], "--shm") == 0)
+    {
+        return run_shm(argc, argv);
+    }
+
+    std::string line = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        line += ' ';
+        line += argv[i];
+    }
+    line += '\n';
+
+    int fd = connect_control();
+    std::string reply;
+    if(fd < 0 || !send_all(fd, line.data(), line.size()) || !read_lines(fd, 1, reply))
+    {
+        printf("clc_ctl : can't talk to %s (is clc running with --control ?)\n", control_socket_path().c_str());
+        return 1;
+    }
+    close(fd);
+    fputs(reply.c_str(), stdout);
+    return reply.compare(0, 2, "ok") == 0 ? 0 : 1;
+}
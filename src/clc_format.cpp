@@ -0,0 +1,130 @@
+#include "../include/clc_format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+size_t t_str_fucn (int64_t time_ns , t_str_buf &out)
+{
+    constexpr int64_t ns_in_sec = 1000000000;
+    char temp[48];
+    char *cursor = temp;
+    char *end = temp + sizeof(temp);
+
+    if(time_ns < 0)
+    {
+        time_ns = 0;
+    }
+    int64_t total_sec = time_ns / ns_in_sec;
+
+    if(total_sec >= 3600)
+    {
+        cursor = std::to_chars(cursor, end, total_sec / 3600).ptr;
+        *cursor++ = '.';
+        cursor = std::to_chars(cursor, end, (total_sec % 3600) / 60).ptr;
+        *cursor++ = '.';
+    }
+    else if (total_sec >= 60)
+    {
+        cursor = std::to_chars(cursor, end, total_sec / 60).ptr;
+        *cursor++ = '.';
+    }
+
+    cursor = std::to_chars(cursor, end, total_sec % 60).ptr;
+    *cursor++ = '.';
+
+    /// 6 digits of fraction like std::to_string did , with leading zeros
+    int64_t micro = (time_ns % ns_in_sec) / 1000;
+    for (int i = 5; i >= 0; i--)
+    {
+        cursor[i] = char('0' + micro % 10);
+        micro /= 10;
+    }
+    cursor += 6;
+
+    size_t len = std::min<size_t>(cursor - temp, out.size() - 1);
+    std::memcpy(out.data(), temp, len);
+    out[len] = '\0';
+    return len;
+}
+
+namespace
+{
+    size_t digit_count(int64_t value)
+    {
+        size_t count = 1;
+        for (; value >= 10; value /= 10)
+        {
+            count++;
+        }
+        return count;
+    }
+}
+
+int next_redraw_ms(int64_t time_ns, bool counting_down)
+{
+    constexpr int64_t ns_in_sec = 1000000000;
+    if(time_ns < 0)
+    {
+        time_ns = 0;
+    }
+    int64_t total_sec = time_ns / ns_in_sec;
+
+    /// the fields t_str_fucn writes for this time , widest unit first : digits and the ns of one
+    /// step of their last digit . walking them against the 8 visible chars finds the last digit shown
+    struct field
+    {
+        size_t width;
+        int64_t unit_ns;
+    };
+    field fields[4];
+    size_t field_count = 0;
+    if(total_sec >= 3600)
+    {
+        fields[field_count++] = {digit_count(total_sec / 3600), 3600 * ns_in_sec};
+        fields[field_count++] = {digit_count((total_sec % 3600) / 60), 60 * ns_in_sec};
+    }
+    else if (total_sec >= 60)
+    {
+        fields[field_count++] = {digit_count(total_sec / 60), 60 * ns_in_sec};
+    }
+    fields[field_count++] = {digit_count(total_sec % 60), ns_in_sec};
+    fields[field_count++] = {6, 1000};
+
+    size_t room = t_str_buf().size() - 1;
+    int64_t step_ns = ns_in_sec;
+    for (size_t i = 0; i < field_count && room != 0; i++)
+    {
+        step_ns = fields[i].unit_ns;
+        /// a field cut short changes its last shown digit 10x slower per missing digit
+        for (size_t cut = fields[i].width; cut > room; cut--)
+        {
+            step_ns *= 10;
+        }
+        room -= std::min(room, fields[i].width + 1);
+    }
+    int64_t remaining_ns = counting_down ? time_ns % step_ns + 1 : step_ns - time_ns % step_ns;
+    return int((remaining_ns + 999999) / 1000000);
+}
+
+size_t lap_str_fucn (uint32_t number , int64_t split_ns , lap_str_buf &out)
+{
+    char digits[12];
+    size_t digits_len = size_t(std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+    size_t len = 0;
+    for (; len + digits_len < 4; len++)
+    {
+        out[len] = ' ';
+    }
+    std::memcpy(out.data() + len, digits, digits_len);
+    len += digits_len;
+    out[len++] = ' ';
+    out[len++] = ' ';
+
+    t_str_buf split;
+    size_t split_len = t_str_fucn(split_ns, split);
+    std::memcpy(out.data() + len, split.data(), split_len);
+    len += split_len;
+    out[len] = '\0';
+    return len;
+}
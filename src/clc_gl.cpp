@@ -0,0 +1,71 @@
+#include "../include/clc_gl.h"
+
+#include <GL/glx.h>
+#include <cstdio>
+
+clc_gl_api clc_gl;
+
+bool clc_gl_load()
+{
+    bool all_found = true;
+#define CLC_GL_LOAD(type, name)                                                             \
+    clc_gl.name = reinterpret_cast<type>(glXGetProcAddressARB((const GLubyte *)"gl" #name)); \
+    if(clc_gl.name == nullptr)                                                              \
+    {                                                                                       \
+        printf("clc. massage [error] : missing gl function gl%s\n", #name);                \
+        all_found = false;                                                                  \
+    }
+    CLC_GL_FUNCS(CLC_GL_LOAD)
+#undef CLC_GL_LOAD
+    return all_found;
+}
+
+static GLuint compile_shader(GLenum type, const char *src)
+{
+    GLuint shader = clc_gl.CreateShader(type);
+    clc_gl.ShaderSource(shader, 1, &src, nullptr);
+    clc_gl.CompileShader(shader);
+
+    GLint ok = 0;
+    clc_gl.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if(!ok)
+    {
+        char log[512];
+        clc_gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        printf("clc. massage [error] : shader compile failed\n%s\n", log);
+        clc_gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint clc_gl_program(const char *vertex_src, const char *fragment_src)
+{
+    GLuint vertex = compile_shader(GL_VERTEX_SHADER, vertex_src);
+    GLuint fragment = compile_shader(GL_FRAGMENT_SHADER, fragment_src);
+    if(vertex == 0 || fragment == 0)
+    {
+        if(vertex) clc_gl.DeleteShader(vertex);
+        if(fragment) clc_gl.DeleteShader(fragment);
+        return 0;
+    }
+
+    GLuint program = clc_gl.CreateProgram();
+    clc_gl.AttachShader(program, vertex);
+    clc_gl.AttachShader(program, fragment);
+    clc_gl.LinkProgram(program);
+    clc_gl.DeleteShader(vertex);
+    clc_gl.DeleteShader(fragment);
+
+    GLint ok = 0;
+    clc_gl.GetProgramiv(program, GL_LINK_STATUS, &ok);
+    if(!ok)
+    {
+        char log[512];
+        clc_gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        printf("clc. massage [error] : shader link failed\n%s\n", log);
+        clc_gl.DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,573 @@
+#include "../include/clc_history.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/clc_persist.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr int64_t ns_in_sec = 1000000000;
+
+    uint32_t record_check(const session_record &record)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull ^ record.timer;
+        for (int64_t word : {record.start_wall_ns, record.end_wall_ns, record.length_ns})
+        {
+            hash ^= uint64_t(word);
+            hash *= 0x100000001b3ull;
+            hash ^= hash >> 29;
+        }
+        return uint32_t(hash ^ (hash >> 32));
+    }
+
+    /// proleptic gregorian , day 0 is 1970-01-01 (howard hinnant's algorithms)
+    int32_t days_from_civil(int year , unsigned month , unsigned day)
+    {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned year_of_era = unsigned(year - era * 400);
+        const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return int32_t(era * 146097 + int(day_of_era) - 719468);
+    }
+
+    void civil_from_days(int32_t days , int &year , unsigned &month , unsigned &day)
+    {
+        days += 719468;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned day_of_era = unsigned(days - era * 146097);
+        const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        const unsigned shifted_month = (5 * day_of_year + 2) / 153;
+        day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+        month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+        year = int(year_of_era) + era * 400 + (month <= 2);
+    }
+
+    int64_t wall_now_ns()
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return int64_t(now.tv_sec) * ns_in_sec + now.tv_nsec;
+    }
+
+    /// offset < 0 appends
+    bool write_all(int fd , const void *data , size_t len , off_t offset)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        size_t written = 0;
+        while(written < len)
+        {
+            ssize_t result = offset < 0 ? ::write(fd, bytes + written, len - written)
+                                        : ::pwrite(fd, bytes + written, len - written, offset + off_t(written));
+            if(result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(result <= 0)
+            {
+                return false;
+            }
+            written += size_t(result);
+        }
+        return true;
+    }
+
+    void add_to_day(std::vector<session_day> &days , int32_t day , int64_t ns , size_t &first_changed)
+    {
+        /// almost always today , the last entry or a new one after it
+        auto entry = days.empty() || days.back().day < day ? days.end()
+                   : std::lower_bound(days.begin(), days.end(), day, [](const session_day &item , int32_t value) { return item.day < value; });
+        if(entry != days.end() && entry->day == day)
+        {
+            entry->sessions++;
+            entry->day_ns += ns;
+        }
+        else
+        {
+            entry = days.insert(entry, session_day {day, 1, ns, 0});
+        }
+        first_changed = std::min(first_changed, size_t(entry - days.begin()));
+    }
+
+    /// the run's length split at every local midnight between its wall start and end
+    void add_session(std::vector<session_day> &days , const session_record &record , size_t &first_changed)
+    {
+        if(record.length_ns <= 0)
+        {
+            return;
+        }
+        const int64_t span = record.end_wall_ns - record.start_wall_ns;
+        if(span <= 0)
+        {
+            add_to_day(days, local_day(record.end_wall_ns), record.length_ns, first_changed);
+            return;
+        }
+
+        int64_t from = record.start_wall_ns;
+        int64_t given = 0;
+        while(from < record.end_wall_ns)
+        {
+            int32_t day = local_day(from);
+            int64_t to = std::min(record.end_wall_ns, local_day_start_ns(day + 1));
+            if(to <= from)
+            {
+                to = record.end_wall_ns;
+            }
+            /// shares of length_ns , not of the wall span , so the days add up to the run exactly
+            int64_t share = to == record.end_wall_ns ? record.length_ns - given
+                          : int64_t(__int128(record.length_ns) * (to - from) / span);
+            add_to_day(days, day, share, first_changed);
+            given += share;
+            from = to;
+        }
+    }
+
+    void fill_before(std::vector<session_day> &days , size_t from)
+    {
+        int64_t before = from == 0 ? 0 : days[from - 1].before_ns + days[from - 1].day_ns;
+        for (size_t i = from; i < days.size(); i++)
+        {
+            days[i].before_ns = before;
+            before += days[i].day_ns;
+        }
+    }
+
+    /// every valid record of the sessions file , stops at the first bad one
+    bool read_sessions(int fd , std::vector<session_record> &out , size_t &file_size)
+    {
+        struct stat info;
+        if(fstat(fd, &info) != 0)
+        {
+            return false;
+        }
+        file_size = size_t(info.st_size);
+        out.resize(file_size / sizeof(session_record));
+        size_t len = out.size() * sizeof(session_record);
+        size_t done = 0;
+        while(done < len)
+        {
+            ssize_t result = pread(fd, reinterpret_cast<char *>(out.data()) + done, len - done, off_t(done));
+            if(result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(result <= 0)
+            {
+                return false;
+            }
+            done += size_t(result);
+        }
+        size_t valid = 0;
+        while(valid < out.size() && session_record_valid(out[valid]))
+        {
+            valid++;
+        }
+        out.resize(valid);
+        return true;
+    }
+
+    void format_duration(int64_t ns , char *buf , size_t size)
+    {
+        long long seconds = (long long)(ns / ns_in_sec);
+        snprintf(buf, size, "%lld:%02lld:%02lld", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    }
+
+    bool parse_day(const char *text , size_t len , int32_t today , int32_t &out)
+    {
+        if(len == 5 && std::strncmp(text, "today", 5) == 0)
+        {
+            out = today;
+            return true;
+        }
+        int year;
+        unsigned month , day;
+        int used = 0;
+        if(len != 10 || sscanf(text, "%4d-%2u-%2u%n", &year, &month, &day, &used) != 3 || used != 10)
+        {
+            return false;
+        }
+        if(month < 1 || month > 12 || day < 1 || day > 31)
+        {
+            return false;
+        }
+        out = days_from_civil(year, month, day);
+        return true;
+    }
+}
+
+session_record make_session_record(size_t timer , int64_t start_wall_ns , int64_t end_wall_ns , int64_t length_ns)
+{
+    session_record record {};
+    record.start_wall_ns = start_wall_ns;
+    record.end_wall_ns = end_wall_ns;
+    record.length_ns = length_ns;
+    record.magic = session_magic;
+    record.timer = uint16_t(timer);
+    record.check = record_check(record);
+    return record;
+}
+
+bool session_record_valid(const session_record &record)
+{
+    return record.magic == session_magic && record.check == record_check(record);
+}
+
+int32_t local_day(int64_t wall_ns)
+{
+    time_t seconds = time_t(wall_ns / ns_in_sec - (wall_ns % ns_in_sec < 0 ? 1 : 0));
+    tm parts {};
+    localtime_r(&seconds, &parts);
+    return days_from_civil(parts.tm_year + 1900, unsigned(parts.tm_mon + 1), unsigned(parts.tm_mday));
+}
+
+int64_t local_day_start_ns(int32_t day)
+{
+    int year;
+    unsigned month , day_of_month;
+    civil_from_days(day, year, month, day_of_month);
+    tm parts {};
+    parts.tm_year = year - 1900;
+    parts.tm_mon = int(month) - 1;
+    parts.tm_mday = int(day_of_month);
+    parts.tm_isdst = -1;
+    return int64_t(mktime(&parts)) * ns_in_sec;
+}
+
+size_t format_day(int32_t day , char *buf , size_t size)
+{
+    int year;
+    unsigned month , day_of_month;
+    civil_from_days(day, year, month, day_of_month);
+    int len = snprintf(buf, size, "%04d-%02u-%02u", year, month, day_of_month);
+    return len < 0 ? 0 : std::min(size_t(len), size - 1);
+}
+
+bool parse_day_range(const char *text , int32_t today , day_range &out)
+{
+    int year;
+    unsigned month , day;
+    civil_from_days(today, year, month, day);
+
+    if(std::strcmp(text, "yesterday") == 0)
+    {
+        out = {today - 1, today - 1};
+        return true;
+    }
+    if(std::strcmp(text, "week") == 0)
+    {
+        /// 1970-01-01 was a thursday
+        int32_t since_monday = ((today + 3) % 7 + 7) % 7;
+        out = {today - since_monday, today};
+        return true;
+    }
+    if(std::strcmp(text, "month") == 0)
+    {
+        out = {days_from_civil(year, month, 1), today};
+        return true;
+    }
+    if(std::strcmp(text, "year") == 0)
+    {
+        out = {days_from_civil(year, 1, 1), today};
+        return true;
+    }
+    if(std::strcmp(text, "all") == 0)
+    {
+        out = {INT32_MIN, INT32_MAX};
+        return true;
+    }
+
+    size_t len = std::strlen(text);
+    if(len >= 2 && text[len - 1] == 'd')
+    {
+        char *end = nullptr;
+        long count = std::strtol(text, &end, 10);
+        if(end == text + len - 1 && count >= 1 && count <= 100000)
+        {
+            out = {today - int32_t(count) + 1, today};
+            return true;
+        }
+    }
+
+    const char *dots = std::strstr(text, "..");
+    if(dots != nullptr)
+    {
+        return parse_day(text, size_t(dots - text), today, out.first) && parse_day(dots + 2, std::strlen(dots + 2), today, out.last) && out.first <= out.last;
+    }
+    if(parse_day(text, len, today, out.first))
+    {
+        out.last = out.first;
+        return true;
+    }
+    return false;
+}
+
+range_total sum_days(const session_day *days , size_t count , day_range range)
+{
+    range_total result;
+    result.begin = std::lower_bound(days, days + count, range.first, [](const session_day &item , int32_t value) { return item.day < value; });
+    result.end = std::upper_bound(result.begin, days + count, range.last, [](int32_t value , const session_day &item) { return value < item.day; });
+    if(result.end != result.begin)
+    {
+        const session_day &last = result.end[-1];
+        result.total_ns = last.before_ns + last.day_ns - result.begin->before_ns;
+    }
+    return result;
+}
+
+void index_sessions(const session_record *records , size_t count , std::vector<session_day> &days)
+{
+    days.clear();
+    size_t first_changed = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        add_session(days, records[i], first_changed);
+    }
+    fill_before(days, 0);
+}
+
+bool session_history::open(const fs::path &sessions_path)
+{
+    index_path = sessions_path;
+    index_path += ".idx";
+    sessions_fd = ::open(sessions_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(sessions_fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if(fstat(sessions_fd, &info) != 0)
+    {
+        close();
+        return false;
+    }
+    size_t file_size = size_t(info.st_size);
+
+    /// the index is small (24 bytes a day) , the writer keeps all of it in memory
+    bool index_ok = false;
+    int fd = ::open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd >= 0)
+    {
+        session_index_header header {};
+        if(pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)) && std::memcmp(header.magic, session_index_magic, sizeof(header.magic)) == 0
+            && file_size % sizeof(session_record) == 0 && header.session_count == file_size / sizeof(session_record) && header.day_count < (1u << 24))
+        {
+            days.resize(header.day_count);
+            ssize_t want = ssize_t(days.size() * sizeof(session_day));
+            index_ok = pread(fd, days.data(), size_t(want), sizeof(header)) == want;
+            session_count = header.session_count;
+        }
+        ::close(fd);
+    }
+
+    if(!index_ok)
+    {
+        std::vector<session_record> records;
+        if(!read_sessions(sessions_fd, records, file_size))
+        {
+            close();
+            return false;
+        }
+        /// a torn tail would hide every later append , cut it
+        if(records.size() * sizeof(session_record) != file_size && ftruncate(sessions_fd, off_t(records.size() * sizeof(session_record))) != 0)
+        {
+            close();
+            return false;
+        }
+        index_sessions(records.data(), records.size(), days);
+        session_count = records.size();
+
+        std::vector<char> image(sizeof(session_index_header) + days.size() * sizeof(session_day));
+        session_index_header header {};
+        std::memcpy(header.magic, session_index_magic, sizeof(header.magic));
+        header.session_count = session_count;
+        header.day_count = days.size();
+        std::memcpy(image.data(), &header, sizeof(header));
+        std::memcpy(image.data() + sizeof(header), days.data(), days.size() * sizeof(session_day));
+        if(!write_file_atomic(index_path, image.data(), image.size(), true))
+        {
+            close();
+            return false;
+        }
+        if(session_count != 0)
+        {
+            printf("clc. massage [alert] : rebuilt %s from %zu sessions\n", index_path.c_str(), size_t(session_count));
+        }
+    }
+
+    index_fd = ::open(index_path.c_str(), O_WRONLY | O_CLOEXEC);
+    if(index_fd < 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void session_history::close()
+{
+    if(sessions_fd >= 0)
+    {
+        ::close(sessions_fd);
+        sessions_fd = -1;
+    }
+    if(index_fd >= 0)
+    {
+        ::close(index_fd);
+        index_fd = -1;
+    }
+}
+
+bool session_history::append(const session_record *records , size_t count , bool sync)
+{
+    if(sessions_fd < 0 || count == 0)
+    {
+        return sessions_fd >= 0;
+    }
+    if(!write_all(sessions_fd, records, count * sizeof(session_record), -1))
+    {
+        return false;
+    }
+    if(sync)
+    {
+        fdatasync(sessions_fd);
+    }
+
+    size_t first_changed = days.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        add_session(days, records[i], first_changed);
+    }
+    fill_before(days, first_changed);
+    session_count += count;
+    return write_index(first_changed, sync);
+}
+
+/// entries first , header last : a crash in between leaves a header that doesn't match and
+/// the next open rebuilds
+bool session_history::write_index(size_t first_changed , bool sync)
+{
+    if(first_changed < days.size())
+    {
+        off_t offset = off_t(sizeof(session_index_header) + first_changed * sizeof(session_day));
+        if(!write_all(index_fd, days.data() + first_changed, (days.size() - first_changed) * sizeof(session_day), offset))
+        {
+            return false;
+        }
+    }
+    session_index_header header {};
+    std::memcpy(header.magic, session_index_magic, sizeof(header.magic));
+    header.session_count = session_count;
+    header.day_count = days.size();
+    if(!write_all(index_fd, &header, sizeof(header), 0))
+    {
+        return false;
+    }
+    if(sync)
+    {
+        fdatasync(index_fd);
+    }
+    return true;
+}
+
+int print_report(const fs::path &sessions_path , const char *range_text)
+{
+    const int32_t today = local_day(wall_now_ns());
+    day_range range;
+    if(!parse_day_range(range_text, today, range))
+    {
+        printf("clc. massage [error] : unknown range %s (today , yesterday , week , month , year , all , <n>d , yyyy-mm-dd , <from>..<to>)\n", range_text);
+        return 1;
+    }
+
+    fs::path index_path = sessions_path;
+    index_path += ".idx";
+    int sessions_fd = ::open(sessions_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info {};
+    if(sessions_fd < 0 || fstat(sessions_fd, &info) != 0)
+    {
+        printf("clc. massage [error] : no sessions yet (%s)\n", sessions_path.c_str());
+        if(sessions_fd >= 0)
+        {
+            ::close(sessions_fd);
+        }
+        return 1;
+    }
+    const uint64_t session_count = uint64_t(info.st_size) / sizeof(session_record);
+
+    /// the index as it is on disk , only the two ends of the range get touched
+    void *mapped = MAP_FAILED;
+    size_t mapped_size = 0;
+    const session_day *days = nullptr;
+    size_t day_count = 0;
+    int index_fd = ::open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(index_fd >= 0)
+    {
+        struct stat index_info;
+        if(fstat(index_fd, &index_info) == 0 && size_t(index_info.st_size) >= sizeof(session_index_header))
+        {
+            mapped_size = size_t(index_info.st_size);
+            mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, index_fd, 0);
+        }
+        ::close(index_fd);
+    }
+    if(mapped != MAP_FAILED)
+    {
+        const session_index_header *header = static_cast<const session_index_header *>(mapped);
+        size_t room = (mapped_size - sizeof(session_index_header)) / sizeof(session_day);
+        if(std::memcmp(header->magic, session_index_magic, sizeof(header->magic)) == 0 && header->session_count == session_count && header->day_count <= room)
+        {
+            days = reinterpret_cast<const session_day *>(static_cast<const char *>(mapped) + sizeof(session_index_header));
+            day_count = size_t(header->day_count);
+        }
+    }
+
+    /// clc died between the two writes (or is writing right now) : sum the sessions file here ,
+    /// the next clc start rewrites the index
+    std::vector<session_day> rebuilt;
+    if(days == nullptr)
+    {
+        std::vector<session_record> records;
+        size_t file_size = 0;
+        read_sessions(sessions_fd, records, file_size);
+        index_sessions(records.data(), records.size(), rebuilt);
+        days = rebuilt.data();
+        day_count = rebuilt.size();
+        printf("clc. massage [alert] : %s is behind , summed %zu sessions instead\n", index_path.c_str(), records.size());
+    }
+    ::close(sessions_fd);
+
+    range_total result = sum_days(days, day_count, range);
+    char day_str[16];
+    char time_str[32];
+    /// a day per line for up to a month , longer ranges only get the total
+    if(int64_t(range.last) - int64_t(range.first) < 31)
+    {
+        for (const session_day *entry = result.begin; entry != result.end; entry++)
+        {
+            format_day(entry->day, day_str, sizeof(day_str));
+            format_duration(entry->day_ns, time_str, sizeof(time_str));
+            printf("%s  %10s  %u session%s\n", day_str, time_str, entry->sessions, entry->sessions == 1 ? "" : "s");
+        }
+    }
+    format_duration(result.total_ns, time_str, sizeof(time_str));
+    printf("total       %10s  over %zu day%s with time\n", time_str, size_t(result.end - result.begin), result.end - result.begin == 1 ? "" : "s");
+
+    if(mapped != MAP_FAILED)
+    {
+        munmap(mapped, mapped_size);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "../include/clc_input.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    constexpr int64_t ns_in_ms = 1000000;
+    /// a press the loop hasn't got to after this long is a server on another clock
+    constexpr uint32_t max_behind_ms = 10000;
+}
+
+bool server_ms_to_monotonic(uint32_t server_ms , int64_t now_ns , int64_t &out_ns)
+{
+    int64_t now_ms = now_ns / ns_in_ms;
+    uint32_t behind_ms = uint32_t(now_ms) - server_ms;
+    if(behind_ms > max_behind_ms)
+    {
+        return false;
+    }
+    out_ns = std::min((now_ms - int64_t(behind_ms)) * ns_in_ms + ns_in_ms / 2, now_ns);
+    return true;
+}
+
+void input_latency::record(int64_t latency_ns)
+{
+    latency_ns = std::max<int64_t>(latency_ns, 0);
+    size_t bucket = std::min<size_t>(size_t(latency_ns / bucket_ns), bucket_count - 1);
+    buckets[bucket]++;
+    stamped++;
+    max_ns = std::max(max_ns, latency_ns);
+}
+
+int64_t input_latency::percentile_ns(double p) const
+{
+    if(stamped == 0)
+    {
+        return 0;
+    }
+    uint64_t target = uint64_t(p * double(stamped - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        seen += buckets[i];
+        if(seen >= target)
+        {
+            return int64_t(i + 1) * bucket_ns;
+        }
+    }
+    return int64_t(bucket_count) * bucket_ns;
+}
+
+void print_input_latency(const input_latency &stats)
+{
+    printf("clc. input : %llu presses stamped by the x server , %llu by the loop\n",
+           (unsigned long long)stats.stamped, (unsigned long long)stats.unstamped);
+    if(stats.stamped == 0)
+    {
+        return;
+    }
+    printf("clc. input : key press -> handled p50 %.2f ms , p99 %.2f ms , max %.2f ms (server times are whole ms , ± 0.5)\n",
+           double(stats.percentile_ns(0.5)) / 1e6, double(stats.percentile_ns(0.99)) / 1e6, double(stats.max_ns) / 1e6);
+    for (size_t i = 0; i < input_latency::bucket_count; i++)
+    {
+        if(stats.buckets[i] != 0)
+        {
+            printf("  %s %6.2f ms : %u\n", i + 1 == input_latency::bucket_count ? ">=" : "< ",
+                   double(int64_t(i + (i + 1 == input_latency::bucket_count ? 0 : 1)) * input_latency::bucket_ns) / 1e6, stats.buckets[i]);
+        }
+    }
+}
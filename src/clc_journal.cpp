@@ -0,0 +1,246 @@
+#include "../include/clc_journal.h"
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/clc_persist.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    uint32_t record_check(const journal_record &record)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull ^ record.type;
+        for (int64_t word : {record.mono_ns, record.wall_ns, record.total_ns, record.aux})
+        {
+            hash ^= uint64_t(word);
+            hash *= 0x100000001b3ull;
+            hash ^= hash >> 29;
+        }
+        return uint32_t(hash ^ (hash >> 32));
+    }
+
+    int64_t wall_now_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+}
+
+journal_record make_journal_record(journal_event type , int64_t mono_ns , int64_t total_ns , int64_t aux , size_t timer)
+{
+    journal_record record {};
+    record.magic = journal_magic;
+    record.type = uint16_t(uint16_t(type) | uint16_t((timer & 0xff) << 8));
+    record.mono_ns = mono_ns;
+    record.wall_ns = wall_now_ns();
+    record.total_ns = total_ns;
+    record.aux = aux;
+    record.check = record_check(record);
+    return record;
+}
+
+bool journal_record_valid(const journal_record &record)
+{
+    return record.magic == journal_magic && record.check == record_check(record);
+}
+
+bool journal_replay(const fs::path &path , journal_summary &out)
+{
+    out = journal_summary {};
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = size_t(info.st_size);
+    if(size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    const journal_record *records = static_cast<const journal_record *>(mapped);
+    size_t count = size / sizeof(journal_record);
+    size_t valid = 0;
+    for (; valid < count; valid++)
+    {
+        const journal_record &record = records[valid];
+        if(!journal_record_valid(record))
+        {
+            break;
+        }
+        size_t timer = journal_record_timer(record);
+        if(timer >= out.timer_totals.size())
+        {
+            out.timer_totals.resize(timer + 1, 0);
+            out.timer_running.resize(timer + 1, 0);
+        }
+        switch (journal_record_event(record))
+        {
+        case journal_event::start:
+            out.timer_running[timer] = 1;
+            break;
+        case journal_event::stop:
+            out.timer_running[timer] = 0;
+            out.runs++;
+            out.run_ns += record.aux;
+            break;
+        case journal_event::snapshot:
+            /// the run stats of the whole set ride on timer 0's snapshot
+            if(timer == 0)
+            {
+                out.runs = record.aux;
+                out.run_ns = record.mono_ns;
+            }
+            out.timer_running[timer] = 0;
+            break;
+        case journal_event::lap:
+            out.laps++;
+            break;
+        case journal_event::reset:
+        case journal_event::checkpoint:
+            break;
+        }
+        if(valid == 0)
+        {
+            out.first_wall_ns = record.wall_ns;
+        }
+        out.last_wall_ns = record.wall_ns;
+        out.timer_totals[timer] = record.total_ns;
+    }
+    if(!out.timer_totals.empty())
+    {
+        out.total_ns = out.timer_totals[0];
+        out.running = out.timer_running[0] != 0;
+    }
+    out.records = valid;
+    out.torn_bytes = size - valid * sizeof(journal_record);
+
+    munmap(mapped, size);
+    return true;
+}
+
+bool journal::open(const fs::path &path , size_t compact_records , journal_summary &summary)
+{
+    file_path = path;
+    compact_limit = compact_records;
+
+    bool existed = journal_replay(path, summary);
+    record_count = summary.records;
+
+    /// a torn tail would hide every later append from replay , so cut it with a compaction too
+    if(existed && (summary.torn_bytes != 0 || (compact_limit != 0 && record_count > compact_limit)))
+    {
+        if(!compact())
+        {
+            return false;
+        }
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    return fd >= 0;
+}
+
+void journal::close()
+{
+    if(fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool journal::append(const journal_record *records , size_t count , bool sync)
+{
+    if(fd < 0 || count == 0)
+    {
+        return fd >= 0;
+    }
+
+    const char *data = reinterpret_cast<const char *>(records);
+    size_t len = count * sizeof(journal_record);
+    size_t written = 0;
+    while(written < len)
+    {
+        ssize_t result = ::write(fd, data + written, len - written);
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result <= 0)
+        {
+            return false;
+        }
+        written += size_t(result);
+    }
+    if(sync)
+    {
+        fdatasync(fd);
+    }
+    record_count += count;
+
+    if(compact_limit != 0 && record_count > compact_limit)
+    {
+        return compact();
+    }
+    return true;
+}
+
+/// the snapshot keeps the total and the run stats , a running stopwatch gets its start back after it
+bool journal::compact()
+{
+    journal_summary summary;
+    /// an empty summary would replace the journal with zero totals , keep it and retry next append
+    if(!journal_replay(file_path, summary))
+    {
+        return false;
+    }
+
+    std::vector<journal_record> compacted;
+    compacted.push_back(make_journal_record(journal_event::snapshot, summary.run_ns, summary.total_ns, summary.runs));
+    for (size_t timer = 0; timer < summary.timer_totals.size(); timer++)
+    {
+        if(timer != 0 && summary.timer_totals[timer] != 0)
+        {
+            compacted.push_back(make_journal_record(journal_event::snapshot, 0, summary.timer_totals[timer], 0, timer));
+        }
+        if(summary.timer_running[timer])
+        {
+            compacted.push_back(make_journal_record(journal_event::start, 0, summary.timer_totals[timer], 0, timer));
+        }
+    }
+    if(!write_file_atomic(file_path, reinterpret_cast<const char *>(compacted.data()), compacted.size() * sizeof(journal_record), true))
+    {
+        return false;
+    }
+    record_count = compacted.size();
+
+    /// the old fd points at the unlinked file now
+    if(fd >= 0)
+    {
+        close();
+        fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "../include/clc_latch.h"
+
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <cstring>
+
+#include "../include/clc_pacing.h"
+
+namespace
+{
+    struct mode_name
+    {
+        latch_mode mode;
+        const char *name;
+    };
+    constexpr mode_name mode_names[] {
+        {latch_mode::off, "off"},
+        {latch_mode::late, "late"},
+        {latch_mode::predict, "predict"},
+    };
+
+    /// eighth of the new sample , steady enough and still follows a change in a few frames
+    void average(int64_t &into , int64_t sample)
+    {
+        into = into == 0 ? sample : into + (sample - into) / 8;
+    }
+}
+
+const char *latch_mode_name(latch_mode mode)
+{
+    for (const mode_name &entry : mode_names)
+    {
+        if(entry.mode == mode)
+        {
+            return entry.name;
+        }
+    }
+    return "?";
+}
+
+bool latch_mode_from_name(const char *name , latch_mode &out)
+{
+    for (const mode_name &entry : mode_names)
+    {
+        if(std::strcmp(entry.name, name) == 0)
+        {
+            out = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool present_predictor::init(int swap_interval)
+{
+    vsync = swap_interval != 0;
+    Display *current_display = glXGetCurrentDisplay();
+    GLXDrawable current_drawable = glXGetCurrentDrawable();
+    if(current_display == nullptr || current_drawable == 0)
+    {
+        return false;
+    }
+    const char *extensions = glXQueryExtensionsString(current_display, DefaultScreen(current_display));
+    if(extensions == nullptr || std::strstr(extensions, "GLX_OML_sync_control") == nullptr)
+    {
+        return false;
+    }
+    auto sync_values = reinterpret_cast<PFNGLXGETSYNCVALUESOMLPROC>(glXGetProcAddressARB((const GLubyte *)"glXGetSyncValuesOML"));
+    auto msc_rate = reinterpret_cast<PFNGLXGETMSCRATEOMLPROC>(glXGetProcAddressARB((const GLubyte *)"glXGetMscRateOML"));
+    int64_t ust , msc , sbc;
+    if(sync_values == nullptr || !sync_values(current_display, current_drawable, &ust, &msc, &sbc))
+    {
+        return false;
+    }
+    /// ust is µs of CLOCK_MONOTONIC on mesa , anything else can't be lined up with our clock
+    int64_t gap_ns = ust * 1000 - pacing_now_ns();
+    if(ust == 0 || gap_ns > 1000000000 || gap_ns < -1000000000)
+    {
+        return false;
+    }
+
+    int32_t numerator = 0 , denominator = 0;
+    if(msc_rate != nullptr && msc_rate(current_display, current_drawable, &numerator, &denominator) && numerator > 0 && denominator > 0)
+    {
+        refresh_ns = int64_t(1000000000) * denominator / numerator;
+    }
+    if(refresh_ns <= 0)
+    {
+        refresh_ns = 16666667;
+    }
+    get_sync_values = reinterpret_cast<void *>(sync_values);
+    display = current_display;
+    drawable = current_drawable;
+    vblank_ns = ust * 1000;
+    return true;
+}
+
+int64_t present_predictor::lead_ns(int64_t latch_ns) const
+{
+    if(get_sync_values == nullptr || !vsync)
+    {
+        return swap_ns;
+    }
+    /// first vblank after the swap gets queued , counted on from the last one we heard of
+    int64_t queued_ns = latch_ns + submit_ns;
+    int64_t periods = queued_ns <= vblank_ns ? 1 : (queued_ns - vblank_ns + refresh_ns - 1) / refresh_ns;
+    return vblank_ns + periods * refresh_ns - latch_ns;
+}
+
+void present_predictor::frame_swapped(int64_t latch_ns , int64_t swap_call_ns , int64_t swap_done_ns)
+{
+    average(submit_ns, swap_call_ns - latch_ns);
+    average(swap_ns, swap_done_ns - latch_ns);
+    if(get_sync_values != nullptr)
+    {
+        int64_t ust , msc , sbc;
+        auto sync_values = reinterpret_cast<PFNGLXGETSYNCVALUESOMLPROC>(get_sync_values);
+        if(sync_values(static_cast<Display *>(display), drawable, &ust, &msc, &sbc) && ust != 0)
+        {
+            vblank_ns = ust * 1000;
+        }
+    }
+}
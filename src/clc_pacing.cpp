@@ -0,0 +1,170 @@
+#include "../include/clc_pacing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+    constexpr int64_t ns_in_ms = 1000000;
+    constexpr int64_t ns_in_sec = 1000000000;
+
+    struct mode_name
+    {
+        pacing_mode mode;
+        const char *name;
+    };
+    constexpr mode_name mode_names[] {
+        {pacing_mode::vsync, "vsync"},
+        {pacing_mode::fixed, "fixed"},
+        {pacing_mode::adaptive, "adaptive"},
+    };
+
+    /// rounds up , waking a bit late is better than spinning an extra turn
+    int ms_until(int64_t target_ns , int64_t now_ns)
+    {
+        return target_ns <= now_ns ? 0 : int((target_ns - now_ns + ns_in_ms - 1) / ns_in_ms);
+    }
+}
+
+const char *pacing_mode_name(pacing_mode mode)
+{
+    for (const mode_name &entry : mode_names)
+    {
+        if(entry.mode == mode)
+        {
+            return entry.name;
+        }
+    }
+    return "?";
+}
+
+bool pacing_mode_from_name(const char *name , pacing_mode &out)
+{
+    for (const mode_name &entry : mode_names)
+    {
+        if(std::strcmp(entry.name, name) == 0)
+        {
+            out = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t pacing_now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return int64_t(now.tv_sec) * ns_in_sec + now.tv_nsec;
+}
+
+void frame_pacer::begin(pacing_mode new_mode , double fps)
+{
+    mode = new_mode;
+    if(fps > 0.0)
+    {
+        period_ns = std::max<int64_t>(int64_t(1e9 / fps), ns_in_ms);
+    }
+    deadline_ns = pacing_now_ns() + period_ns;
+    last_frame_ns = 0;
+}
+
+int frame_pacer::wait_ms(int content_ms , bool want_frame , int64_t now_ns) const
+{
+    switch (mode)
+    {
+    case pacing_mode::vsync:
+        return want_frame ? 0 : content_ms;
+    case pacing_mode::fixed:
+        /// the next frame is owed at the deadline , not when the digits change
+        if(want_frame || content_ms >= 0)
+        {
+            /// a ms early on purpose , wait_for_deadline sleeps the rest precisely
+            return std::max(ms_until(deadline_ns, now_ns) - 1, 0);
+        }
+        return -1;
+    case pacing_mode::adaptive:
+        if(want_frame)
+        {
+            return 0;
+        }
+        return content_ms >= 0 ? content_ms : ms_until(last_frame_ns + paused_period_ns, now_ns);
+    }
+    return content_ms;
+}
+
+bool frame_pacer::tick_due(bool running , int64_t now_ns) const
+{
+    return mode == pacing_mode::adaptive && !running && now_ns - last_frame_ns >= paused_period_ns;
+}
+
+bool frame_pacer::ready(int64_t now_ns) const
+{
+    return mode != pacing_mode::fixed || deadline_ns - now_ns <= ns_in_ms;
+}
+
+void frame_pacer::wait_for_deadline()
+{
+    if(mode != pacing_mode::fixed)
+    {
+        return;
+    }
+    timespec target;
+    target.tv_sec = time_t(deadline_ns / ns_in_sec);
+    target.tv_nsec = long(deadline_ns % ns_in_sec);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR)
+    {
+    }
+
+    deadline_ns += period_ns;
+    int64_t now_ns = pacing_now_ns();
+    if(deadline_ns < now_ns)
+    {
+        /// paused for a while or a frame took too long : don't fire a burst to catch up
+        deadline_ns = now_ns + period_ns;
+    }
+}
+
+void frame_histogram::record(int64_t swap_ns)
+{
+    if(last_swap_ns != 0 && swap_ns - last_swap_ns < ns_in_sec)
+    {
+        size_t bucket = std::min<size_t>(size_t((swap_ns - last_swap_ns) / bucket_ns), bucket_count - 1);
+        buckets[bucket]++;
+        frames++;
+    }
+    last_swap_ns = swap_ns;
+}
+
+int64_t frame_histogram::percentile_ns(double p) const
+{
+    if(frames == 0)
+    {
+        return 0;
+    }
+    uint64_t target = uint64_t(p * double(frames - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        seen += buckets[i];
+        if(seen >= target)
+        {
+            return int64_t(i + 1) * bucket_ns;
+        }
+    }
+    return int64_t(bucket_count) * bucket_ns;
+}
+
+uint32_t frame_histogram::max_bucket() const
+{
+    return *std::max_element(buckets, buckets + bucket_count);
+}
+
+void frame_histogram::clear()
+{
+    std::fill(buckets, buckets + bucket_count, 0u);
+    frames = 0;
+    last_swap_ns = 0;
+}
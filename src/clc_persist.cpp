@@ -0,0 +1,735 @@
+#include "../include/clc_persist.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "../include/clc_pacing.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int64_t wall_now_ns()
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+}
+
+bool write_file_atomic(const fs::path &path , const char *data , size_t len , bool sync)
+{
+    fs::path temp_path = path;
+    temp_path += ".tmp";
+
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    size_t written = 0;
+    while(written < len)
+    {
+        ssize_t result = write(fd, data + written, len - written);
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result <= 0)
+        {
+            close(fd);
+            unlink(temp_path.c_str());
+            return false;
+        }
+        written += size_t(result);
+    }
+
+    if(sync && fdatasync(fd) != 0)
+    {
+        close(fd);
+        unlink(temp_path.c_str());
+        return false;
+    }
+    close(fd);
+
+    if(rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    /// the rename itself lives in the directory , sync that too
+    if(sync)
+    {
+        int dir_fd = open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(dir_fd >= 0)
+        {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+    return true;
+}
+
+size_t encode_saved_time(int64_t total_ns , char *buf , size_t size)
+{
+    char *end = buf + size;
+    size_t magic_len = sizeof(saved_time_magic) - 1;
+    if(size < magic_len + 2)
+    {
+        return 0;
+    }
+    std::memcpy(buf, saved_time_magic, magic_len);
+    char *cursor = buf + magic_len;
+    *cursor++ = ' ';
+    auto result = std::to_chars(cursor, end - 1, total_ns);
+    if(result.ec != std::errc())
+    {
+        return 0;
+    }
+    cursor = result.ptr;
+    *cursor++ = '\n';
+    return size_t(cursor - buf);
+}
+
+bool load_saved_time(const fs::path &path , duration_ns &out)
+{
+    std::ifstream inFile(path);
+    if(!inFile.is_open())
+    {
+        return false;
+    }
+    std::string first_word;
+    inFile >> first_word;
+
+    int64_t previous_ns = 0;
+    if(first_word == saved_time_magic)
+    {
+        inFile >> previous_ns;
+    }
+    else
+    {
+        /// before clc1 the file was just seconds as double
+        previous_ns = std::llround(std::strtod(first_word.c_str(), nullptr) * 1e9);
+    }
+    out = duration_ns(previous_ns);
+    return true;
+}
+
+bool load_saved_set(const fs::path &path , std::vector<saved_timer> &out)
+{
+    std::ifstream in(path);
+    std::string magic;
+    if(!(in >> magic) || (magic != saved_set_magic && magic != saved_set_magic_v1))
+    {
+        return false;
+    }
+    const bool has_target = magic == saved_set_magic;
+    out.clear();
+    saved_timer timer;
+    while(in >> timer.total_ns)
+    {
+        if(has_target && !(in >> timer.target_ns))
+        {
+            break;
+        }
+        in.get();
+        std::getline(in, timer.name);
+        out.push_back(timer);
+    }
+    return !out.empty();
+}
+
+bool checkpointer::start(const fs::path &file , int64_t interval_ns , bool sync , journal *events_journal , shm_export *live_export , session_history *history)
+{
+    file_path = file;
+    set_file_path = file.parent_path() / "timers";
+    events = events_journal;
+    live = live_export;
+    sessions = history;
+    interval = interval_ns;
+    sync_writes = sync;
+
+    std::error_code error;
+    fs::create_directories(file_path.parent_path(), error);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &old_signal_mask);
+    signals_blocked = true;
+
+    signal_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(signal_fd < 0 || wake_fd < 0)
+    {
+        stop();
+        return false;
+    }
+
+    quit = false;
+    worker = std::thread(&checkpointer::run, this);
+    return true;
+}
+
+void checkpointer::stop()
+{
+    if(worker.joinable())
+    {
+        quit = true;
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+        worker.join();
+    }
+    if(trace_file != nullptr)
+    {
+        fclose(trace_file);
+        trace_file = nullptr;
+    }
+    if(signal_fd >= 0)
+    {
+        close(signal_fd);
+        signal_fd = -1;
+    }
+    if(wake_fd >= 0)
+    {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    /// with the signalfd gone nothing would ever take SIGINT / SIGTERM , hand them back
+    if(signals_blocked)
+    {
+        pthread_sigmask(SIG_SETMASK, &old_signal_mask, nullptr);
+        signals_blocked = false;
+    }
+}
+
+bool checkpointer::push(const request &item , bool urgent , bool wait_for_room)
+{
+    bool queued_ok = queue.try_push(item);
+    if(!queued_ok && wait_for_room)
+    {
+        /// the worker drains the whole queue before it writes , so this is one write long at most
+        waited_count.fetch_add(1, std::memory_order_relaxed);
+        do
+        {
+            uint64_t one = 1;
+            ssize_t ignored = write(wake_fd, &one, sizeof(one));
+            (void)ignored;
+            std::this_thread::yield();
+        } while(!queue.try_push(item));
+        queued_ok = true;
+    }
+    if(!queued_ok)
+    {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        urgent = true;
+    }
+    else
+    {
+        request_count.fetch_add(1, std::memory_order_relaxed);
+        uint64_t queued = queue.size();
+        if(queued > max_queued.load(std::memory_order_relaxed))
+        {
+            max_queued.store(queued, std::memory_order_relaxed);
+        }
+        /// half full is worth waking the worker early for , it would drop soon
+        urgent = urgent || queued >= 512;
+    }
+
+    if(urgent)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    return queued_ok;
+}
+
+void checkpointer::publish(size_t timer , const stopwatch &new_state , journal_event event , const char *name)
+{
+    clc_clock::time_point now = clc_clock::now();
+    if(timer >= producer_states.size())
+    {
+        producer_states.resize(timer + 1);
+        producer_names.resize(timer + 1);
+    }
+
+    request item;
+    item.kind = request::state_update;
+    item.enqueue_ns = pacing_now_ns();
+    item.state = new_state;
+    item.timer = uint8_t(timer);
+    snprintf(item.text, sizeof(item.text), "%s", name);
+    if(events != nullptr)
+    {
+        int64_t aux = event == journal_event::stop ? (new_state.saved - producer_states[timer].saved).count() : 0;
+        item.records[0] = make_journal_record(event, now.time_since_epoch().count(), new_state.elapsed(now).count(), aux, timer);
+        item.record_count = 1;
+    }
+    producer_states[timer] = new_state;
+    producer_names[timer] = item.text;
+    if(live != nullptr)
+    {
+        live->update(timer, new_state, item.text);
+    }
+
+    if(worker.joinable())
+    {
+        /// a start , stop or reset is a journal record and may end a session , a later one
+        /// doesn't stand in for it the way the next checkpoint does , so it waits instead of dropping
+        push(item, false, true);
+    }
+    else if(item.record_count != 0)
+    {
+        /// no worker , the next flush() takes it along
+        batch.push_back(item.records[0]);
+        batch_enqueue_ns.push_back(item.enqueue_ns);
+    }
+}
+
+bool checkpointer::publish_laps(lap_ring &laps)
+{
+    if(events == nullptr)
+    {
+        /// nowhere to keep them
+        laps.flushed = laps.pushed;
+        return true;
+    }
+    while(laps.pending() != 0)
+    {
+        request item;
+        item.kind = request::lap_records;
+        item.enqueue_ns = pacing_now_ns();
+        size_t count = std::min(laps.pending(), lap_batch);
+        for (size_t i = 0; i < count; i++)
+        {
+            const lap_entry &lap = laps.at(laps.flushed + i);
+            item.records[i] = make_journal_record(journal_event::lap, lap.mono_ns, lap.total_ns, lap.split_ns, lap.timer);
+        }
+        item.record_count = uint8_t(count);
+
+        if(worker.joinable())
+        {
+            if(!push(item, false))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            batch.insert(batch.end(), item.records, item.records + count);
+            batch_enqueue_ns.push_back(item.enqueue_ns);
+        }
+        laps.flushed += count;
+    }
+    return true;
+}
+
+void checkpointer::log(const char *format , ...)
+{
+    request item;
+    item.kind = request::log_line;
+    item.enqueue_ns = pacing_now_ns();
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(item.text, sizeof(item.text), format, args);
+    va_end(args);
+
+    if(worker.joinable())
+    {
+        push(item, true);
+    }
+    else
+    {
+        puts(item.text);
+    }
+}
+
+bool checkpointer::flush()
+{
+    if(!worker.joinable())
+    {
+        return write_state(producer_states, producer_names, false);
+    }
+
+    request item;
+    item.kind = request::flush_now;
+    item.enqueue_ns = pacing_now_ns();
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex);
+        item.flush_id = ++flush_requested;
+    }
+    push(item, true, true);
+
+    std::unique_lock<std::mutex> lock(flush_mutex);
+    flush_done.wait_for(lock, std::chrono::seconds(5), [&] { return flush_completed >= item.flush_id; });
+    return flush_completed >= item.flush_id && flush_ok;
+}
+
+void checkpointer::record_latency(int64_t enqueue_ns , int64_t done_ns)
+{
+    uint64_t latency = uint64_t(std::max<int64_t>(done_ns - enqueue_ns, 1));
+    size_t bucket = size_t(63 - __builtin_clzll(latency));
+    if(bucket >= io_stats::bucket_count)
+    {
+        bucket = io_stats::bucket_count - 1;
+    }
+    latency_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+bool checkpointer::write_state(const std::vector<stopwatch> &states , const std::vector<std::string> &names , bool periodic)
+{
+    if(states.empty())
+    {
+        return true;
+    }
+    clc_clock::time_point now = clc_clock::now();
+    int64_t total_ns = states[0].elapsed(now).count();
+    if(events != nullptr)
+    {
+        for (size_t i = 0; periodic && i < states.size(); i++)
+        {
+            if(states[i].running)
+            {
+                batch.push_back(make_journal_record(journal_event::checkpoint, now.time_since_epoch().count(), states[i].elapsed(now).count(), 0, i));
+            }
+        }
+        if(!events->append(batch.data(), batch.size(), sync_writes))
+        {
+            printf("clc. massage [error] : can't append to the journal\n");
+        }
+        batch.clear();
+    }
+    if(sessions != nullptr && !session_batch.empty())
+    {
+        if(!sessions->append(session_batch.data(), session_batch.size(), sync_writes))
+        {
+            printf("clc. massage [error] : can't append to the session history\n");
+        }
+        session_batch.clear();
+    }
+
+    char buf[64];
+    size_t len = encode_saved_time(total_ns, buf, sizeof(buf));
+    bool ok = write_file_atomic(file_path, buf, len, sync_writes);
+
+    set_text = saved_set_magic;
+    set_text += '\n';
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        char number[24];
+        auto result = std::to_chars(number, number + sizeof(number), states[i].elapsed(now).count());
+        set_text.append(number, result.ptr);
+        set_text += ' ';
+        result = std::to_chars(number, number + sizeof(number), states[i].target.count());
+        set_text.append(number, result.ptr);
+        set_text += ' ';
+        set_text += names[i];
+        set_text += '\n';
+    }
+    ok = write_file_atomic(set_file_path, set_text.data(), set_text.size(), sync_writes) && ok;
+    write_count.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t done_ns = pacing_now_ns();
+    for (int64_t enqueue_ns : batch_enqueue_ns)
+    {
+        record_latency(enqueue_ns, done_ns);
+    }
+    batch_enqueue_ns.clear();
+    return ok;
+}
+
+void checkpointer::end_run(size_t timer , const stopwatch &before , clc_clock::time_point end)
+{
+    int64_t length_ns = (end - before.start_time).count();
+    if(length_ns <= 0)
+    {
+        return;
+    }
+    /// the boottime half of the run's stamp , runs are short next to a suspend so "now" is close enough to the end
+    const bool counted = current_suspend_policy() == suspend_policy::count;
+    int64_t slept_ns = before.slept_ns();
+    if(slept_ns >= 1000000000)
+    {
+        printf("clc. massage [alert] : timer %zu ran through %llds of suspend , %s\n", timer, (long long)(slept_ns / 1000000000), counted ? "counted" : "not counted (--suspend count)");
+    }
+    if(sessions == nullptr)
+    {
+        return;
+    }
+    /// the clc clock has no wall time , so both ends are placed back from now
+    /// a run that skipped its sleep still started that much earlier on the wall
+    int64_t end_wall_ns = wall_now_ns() - (clock_now_ns() - end.time_since_epoch().count());
+    int64_t start_wall_ns = end_wall_ns - length_ns - (counted ? 0 : std::max<int64_t>(slept_ns, 0));
+    session_batch.push_back(make_session_record(timer, start_wall_ns, end_wall_ns, length_ns));
+}
+
+void checkpointer::run()
+{
+    pollfd fds[2] {{signal_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+    /// producer_states belong to the main thread , the worker only knows what came through the queue
+    std::vector<stopwatch> states;
+    std::vector<std::string> names;
+    bool changed = false;
+    int64_t next_write_ns = clock_now_ns() + interval;
+    /// runs still going when clc goes away end with it , the next start doesn't resume them
+    auto end_running_runs = [&]
+    {
+        clc_clock::time_point end = clc_clock::now();
+        for (size_t i = 0; i < states.size(); i++)
+        {
+            if(states[i].running)
+            {
+                end_run(i, states[i], end);
+            }
+        }
+    };
+
+    while(true)
+    {
+        int64_t wait_ns = next_write_ns - clock_now_ns();
+        int timeout_ms = wait_ns > 0 ? int((wait_ns + 999999) / 1000000) : 0;
+        int ready = poll(fds, 2, timeout_ms);
+        if(ready < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            uint64_t count;
+            ssize_t ignored = read(wake_fd, &count, sizeof(count));
+            (void)ignored;
+        }
+
+        /// drain everything the main thread sent
+        uint64_t flush_id = 0;
+        auto drain = [&]
+        {
+            bool printed = false;
+            request item;
+            while(queue.try_pop(item))
+            {
+                switch (item.kind)
+                {
+                case request::state_update:
+                    if(item.timer >= states.size())
+                    {
+                        states.resize(item.timer + 1);
+                        names.resize(item.timer + 1);
+                    }
+                    /// a stop adds the run to saved , a reset while running starts a new one at its time
+                    if(states[item.timer].running && (!item.state.running || item.state.start_time != states[item.timer].start_time))
+                    {
+                        const stopwatch &before = states[item.timer];
+                        end_run(item.timer, before, item.state.running ? item.state.start_time : before.start_time + (item.state.saved - before.saved));
+                    }
+                    states[item.timer] = item.state;
+                    names[item.timer] = item.text;
+                    changed = true;
+                    batch.insert(batch.end(), item.records, item.records + item.record_count);
+                    batch_enqueue_ns.push_back(item.enqueue_ns);
+                    break;
+                case request::lap_records:
+                    /// no new state , but a paused set still has to write them out
+                    changed = true;
+                    batch.insert(batch.end(), item.records, item.records + item.record_count);
+                    batch_enqueue_ns.push_back(item.enqueue_ns);
+                    break;
+                case request::log_line:
+                    puts(item.text);
+                    printed = true;
+                    record_latency(item.enqueue_ns, pacing_now_ns());
+                    break;
+                case request::trace_line:
+                    fputs(item.text, trace_file);
+                    fputc('\n', trace_file);
+                    break;
+                case request::flush_now:
+                    flush_id = item.flush_id;
+                    batch_enqueue_ns.push_back(item.enqueue_ns);
+                    break;
+                }
+            }
+            if(printed)
+            {
+                fflush(stdout);
+            }
+        };
+        drain();
+
+        if(fds[0].revents & POLLIN)
+        {
+            signalfd_siginfo info;
+            ssize_t ignored = read(signal_fd, &info, sizeof(info));
+            (void)ignored;
+            /// laps the producers haven't handed over yet . one of them can hold the lock while it
+            /// waits for queue room , so keep draining until the lock comes free (a second at most)
+            lap_ring *laps = exit_laps.load();
+            std::mutex *laps_lock = exit_laps_lock.load();
+            for (int tries = 0; laps != nullptr && laps_lock != nullptr && events != nullptr && tries < 1000; tries++)
+            {
+                if(laps_lock->try_lock())
+                {
+                    for (; laps->pending() != 0; laps->flushed++)
+                    {
+                        const lap_entry &lap = laps->at(laps->flushed);
+                        batch.push_back(make_journal_record(journal_event::lap, lap.mono_ns, lap.total_ns, lap.split_ns, lap.timer));
+                    }
+                    laps_lock->unlock();
+                    break;
+                }
+                drain();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            end_running_runs();
+            write_state(states, names, false);
+            if(trace_file != nullptr)
+            {
+                fflush(trace_file);
+            }
+            if(void (*hook)() = exit_hook.load())
+            {
+                hook();
+            }
+            printf("clc. massage [alert] : got signal %u , last time got saved\n", info.ssi_signo);
+            fflush(stdout);
+            std::_Exit(128 + int(info.ssi_signo));
+        }
+
+        int64_t now_ns = clock_now_ns();
+        if(flush_id != 0)
+        {
+            bool ok = write_state(states, names, false);
+            changed = false;
+            next_write_ns = now_ns + interval;
+
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            flush_completed = flush_id;
+            flush_ok = ok;
+            flush_done.notify_all();
+        }
+        else if(now_ns >= next_write_ns || quit)
+        {
+            /// a running stopwatch changes every instant , a paused one only when published
+            bool any_running = std::any_of(states.begin(), states.end(), [](const stopwatch &timer) { return timer.running; });
+            if((any_running || changed) && !write_state(states, names, !quit))
+            {
+                printf("clc. massage [error] : checkpoint of %s failed\n", file_path.c_str());
+            }
+            changed = false;
+            next_write_ns = now_ns + interval;
+            if(trace_file != nullptr)
+            {
+                fflush(trace_file);
+            }
+        }
+
+        if(quit)
+        {
+            end_running_runs();
+            if(sessions != nullptr && !session_batch.empty())
+            {
+                sessions->append(session_batch.data(), session_batch.size(), sync_writes);
+                session_batch.clear();
+            }
+            break;
+        }
+    }
+}
+
+bool checkpointer::open_trace(const fs::path &path)
+{
+    trace_file = fopen(path.c_str(), "we");
+    if(trace_file != nullptr)
+    {
+        /// one write() per ~1500 frames
+        setvbuf(trace_file, nullptr, _IOFBF, 1 << 17);
+    }
+    return trace_file != nullptr;
+}
+
+void checkpointer::trace(const char *format , ...)
+{
+    if(trace_file == nullptr)
+    {
+        return;
+    }
+    request item;
+    item.kind = request::trace_line;
+    item.enqueue_ns = pacing_now_ns();
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(item.text, sizeof(item.text), format, args);
+    va_end(args);
+
+    if(worker.joinable())
+    {
+        push(item, false);
+    }
+    else
+    {
+        fputs(item.text, trace_file);
+        fputc('\n', trace_file);
+    }
+}
+
+void checkpointer::set_exit_hook(void (*hook)())
+{
+    exit_hook = hook;
+}
+
+void checkpointer::set_exit_laps(lap_ring *laps , std::mutex *lock)
+{
+    exit_laps_lock = lock;
+    exit_laps = laps;
+}
+
+io_stats checkpointer::stats() const
+{
+    io_stats result;
+    for (size_t i = 0; i < io_stats::bucket_count; i++)
+    {
+        result.latency_buckets[i] = latency_buckets[i].load(std::memory_order_relaxed);
+    }
+    result.requests = request_count.load(std::memory_order_relaxed);
+    result.writes = write_count.load(std::memory_order_relaxed);
+    result.dropped = dropped_count.load(std::memory_order_relaxed);
+    result.waited = waited_count.load(std::memory_order_relaxed);
+    result.max_queued = max_queued.load(std::memory_order_relaxed);
+    return result;
+}
+
+void print_io_stats(const io_stats &stats)
+{
+    printf("clc. io : %llu requests , %llu writes , %llu dropped , %llu waited for room , queue peak %llu\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.writes,
+           (unsigned long long)stats.dropped, (unsigned long long)stats.waited, (unsigned long long)stats.max_queued);
+    printf("clc. io : enqueue -> on disk latency\n");
+    for (size_t i = 0; i < io_stats::bucket_count; i++)
+    {
+        if(stats.latency_buckets[i] != 0)
+        {
+            printf("  >= %12.3f us : %llu\n", double(uint64_t(1) << i) / 1000.0, (unsigned long long)stats.latency_buckets[i]);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#include "../include/clc_profile.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+    constexpr const char *phase_names[profile_phase_count] {"wait", "events", "format", "pace", "text", "shapes", "swap"};
+
+    int64_t process_cpu_ns()
+    {
+        timespec now;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+        return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+}
+
+const char *profile_phase_name(profile_phase phase)
+{
+    return phase_names[size_t(phase)];
+}
+
+void frame_profiler::next_turn(bool drew , int64_t now_ns)
+{
+    std::copy(current, current + profile_phase_count, last);
+    last_start_ns = current_start_ns;
+    last_drew = drew;
+    if(current_start_ns != 0)
+    {
+        turns++;
+    }
+
+    /// turns that only waited and found nothing to draw would drown the averages
+    if(drew)
+    {
+        for (size_t i = 0; i < profile_phase_count; i++)
+        {
+            sum[i] += current[i];
+            max[i] = std::max(max[i], current[i]);
+        }
+        frames++;
+    }
+
+    std::fill(current, current + profile_phase_count, 0);
+    current_start_ns = now_ns;
+}
+
+frame_profiler::summary frame_profiler::take_summary()
+{
+    summary result;
+    const int64_t wall_ns = pacing_now_ns();
+    const int64_t cpu_ns = process_cpu_ns();
+    for (size_t i = 0; i < profile_phase_count; i++)
+    {
+        result.avg_ms[i] = frames == 0 ? 0.0 : double(sum[i]) / double(frames) / 1e6;
+        result.max_ms[i] = double(max[i]) / 1e6;
+    }
+    if(summary_wall_ns != 0 && wall_ns > summary_wall_ns)
+    {
+        result.cpu_percent = 100.0 * double(cpu_ns - summary_cpu_ns) / double(wall_ns - summary_wall_ns);
+    }
+    result.frames = frames;
+
+    std::fill(sum, sum + profile_phase_count, 0);
+    std::fill(max, max + profile_phase_count, 0);
+    frames = 0;
+    summary_wall_ns = wall_ns;
+    summary_cpu_ns = cpu_ns;
+    return result;
+}
@@ -0,0 +1,174 @@
+#include "../include/clc_shapes.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const char shape_vertex_src[] = R"(#version 330 core
+layout(location = 0) in vec2 pos;
+uniform vec2 view;
+void main()
+{
+    gl_Position = vec4(pos.x / view.x * 2.0 - 1.0, 1.0 - pos.y / view.y * 2.0, 0.0, 1.0);
+}
+)";
+
+    const char shape_fragment_src[] = R"(#version 330 core
+uniform vec4 color;
+out vec4 out_color;
+void main()
+{
+    out_color = color;
+}
+)";
+}
+
+bool shape_layer::create(float view_width , float view_height)
+{
+    view_w = view_width;
+    view_h = view_height;
+
+    program = clc_gl_program(shape_vertex_src, shape_fragment_src);
+    if(program == 0)
+    {
+        return false;
+    }
+    color_location = clc_gl.GetUniformLocation(program, "color");
+    view_location = clc_gl.GetUniformLocation(program, "view");
+
+    clc_gl.GenVertexArrays(1, &vao);
+    clc_gl.GenBuffers(1, &vbo);
+    clc_gl.BindVertexArray(vao);
+    clc_gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+    clc_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    clc_gl.EnableVertexAttribArray(0);
+    clc_gl.BindVertexArray(0);
+    return true;
+}
+
+void shape_layer::destroy()
+{
+    if(vbo) clc_gl.DeleteBuffers(1, &vbo);
+    if(vao) clc_gl.DeleteVertexArrays(1, &vao);
+    if(program) clc_gl.DeleteProgram(program);
+    vbo = vao = program = 0;
+    shapes.clear();
+    vertices.clear();
+    uploaded_floats = vbo_capacity_floats = 0;
+}
+
+void shape_layer::ring_vertices(std::vector<float> &out , float cx , float cy , float inner_radius , float outer_radius , int segments , float start_angle , float sweep)
+{
+    segments = std::max(segments, 1);
+    const float step = sweep / float(segments);
+    for (int i = 0; i <= segments; i++)
+    {
+        float angle = start_angle + step * float(i);
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        out.push_back(cx + c * outer_radius);
+        out.push_back(cy + s * outer_radius);
+        out.push_back(cx + c * inner_radius);
+        out.push_back(cy + s * inner_radius);
+    }
+}
+
+shape_layer::shape_id shape_layer::add(const std::vector<float> &shape_vertices , int segments)
+{
+    shape new_shape;
+    new_shape.first = GLint(vertices.size() / 2);
+    new_shape.count = GLsizei(shape_vertices.size() / 2);
+    new_shape.segments = segments;
+    vertices.insert(vertices.end(), shape_vertices.begin(), shape_vertices.end());
+    shapes.push_back(new_shape);
+    return shapes.size() - 1;
+}
+
+shape_layer::shape_id shape_layer::add_ring(float cx , float cy , float inner_radius , float outer_radius , int segments , float start_angle , float sweep)
+{
+    std::vector<float> ring;
+    ring_vertices(ring, cx, cy, inner_radius, outer_radius, segments, start_angle, sweep);
+    return add(ring, std::max(segments, 1));
+}
+
+shape_layer::shape_id shape_layer::add_circle(float cx , float cy , float r , int segments , float line_width)
+{
+    return add_arc(cx, cy, r, segments, 0.0f, 6.2831853f, line_width);
+}
+
+shape_layer::shape_id shape_layer::add_arc(float cx , float cy , float r , int segments , float start_angle , float sweep , float line_width)
+{
+    float half = line_width * 0.5f;
+    return add_ring(cx, cy, std::max(r - half, 0.0f), r + half, segments, start_angle, sweep);
+}
+
+shape_layer::shape_id shape_layer::add_rect(float x , float y , float width , float height)
+{
+    std::vector<float> rect {x, y, x, y + height, x + width, y, x + width, y + height};
+    return add(rect, 0);
+}
+
+void shape_layer::set_rect(shape_id id , float x , float y , float width , float height)
+{
+    if(id >= shapes.size() || shapes[id].count != 4 || shapes[id].segments != 0)
+    {
+        return;
+    }
+    const size_t first_float = size_t(shapes[id].first) * 2;
+    const float rect[8] {x, y, x, y + height, x + width, y, x + width, y + height};
+    std::copy(rect, rect + 8, vertices.begin() + first_float);
+    if(first_float < uploaded_floats)
+    {
+        clc_gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+        clc_gl.BufferSubData(GL_ARRAY_BUFFER, GLintptr(first_float * sizeof(float)), GLsizeiptr(sizeof(rect)), rect);
+    }
+}
+
+/// new shapes go to the gpu in one upload , the buffer only grows (doubling) when it's full
+void shape_layer::flush()
+{
+    if(uploaded_floats == vertices.size())
+    {
+        return;
+    }
+    clc_gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+    if(vertices.size() > vbo_capacity_floats)
+    {
+        vbo_capacity_floats = std::max(vertices.size(), vbo_capacity_floats * 2);
+        clc_gl.BufferData(GL_ARRAY_BUFFER, GLsizeiptr(vbo_capacity_floats * sizeof(float)), nullptr, GL_STATIC_DRAW);
+        uploaded_floats = 0;
+    }
+    clc_gl.BufferSubData(GL_ARRAY_BUFFER, GLintptr(uploaded_floats * sizeof(float)), GLsizeiptr((vertices.size() - uploaded_floats) * sizeof(float)), &vertices[uploaded_floats]);
+    uploaded_floats = vertices.size();
+}
+
+void shape_layer::draw(shape_id id , float r , float g , float b , float a , float fraction)
+{
+    if(id >= shapes.size())
+    {
+        return;
+    }
+    flush();
+
+    const shape &target = shapes[id];
+    GLsizei count = target.count;
+    if(target.segments != 0 && fraction < 1.0f)
+    {
+        /// ring strips are 2 vertices per step , draw only the first part of the sweep
+        int steps = int(std::max(fraction, 0.0f) * float(target.segments));
+        count = steps == 0 ? 0 : GLsizei(2 * (steps + 1));
+    }
+    if(count == 0)
+    {
+        return;
+    }
+
+    clc_gl.UseProgram(program);
+    clc_gl.Uniform2f(view_location, view_w, view_h);
+    clc_gl.Uniform4f(color_location, r, g, b, a);
+    clc_gl.BindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, target.first, count);
+    clc_gl.BindVertexArray(0);
+    clc_gl.UseProgram(0);
+}
@@ -0,0 +1,151 @@
+#include "../include/clc_shm.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/clc_clock.h"
+#include "../include/clc_stopwatch.h"
+
+static_assert(clc_shm_max_timers == stopwatch_set::max_timers, "every timer needs a slot");
+
+namespace
+{
+    int64_t monotonic_now()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+}
+
+bool shm_export::open()
+{
+    snprintf(shm_name, sizeof(shm_name), "/clc-%u", unsigned(getuid()));
+    /// the seqlock takes one writer : the flock on the segment is held until close() , a second
+    /// clc of the same user gets EWOULDBLOCK and exports nothing . the kernel drops the lock when
+    /// the owner dies , so a segment left by a crash is simply taken over
+    int fd = -1;
+    for (int attempt = 0; attempt < 3 && fd < 0; attempt++)
+    {
+        /// readable by everyone , a stopwatch isn't a secret and agents may run as another user
+        fd = shm_open(shm_name, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            return false;
+        }
+        if(flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            /// only EWOULDBLOCK is another writer , ENOLCK , EINTR and the rest are plain failures
+            int error = errno;
+            ::close(fd);
+            if(error == EWOULDBLOCK)
+            {
+                printf("clc. massage [alert] : another clc writes /dev/shm%s , this one doesn't\n", shm_name);
+            }
+            else
+            {
+                printf("clc. massage [error] : can't lock /dev/shm%s : %s\n", shm_name, strerror(error));
+            }
+            return false;
+        }
+        /// the owner may have unlinked it between our open and its exit , then the lock is on
+        /// a segment nobody can find anymore : open the new one instead
+        struct stat locked , current;
+        char path[48];
+        snprintf(path, sizeof(path), "/dev/shm%s", shm_name);
+        if(fstat(fd, &locked) != 0 || stat(path, &current) != 0 || locked.st_ino != current.st_ino)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if(fd < 0 || ftruncate(fd, sizeof(clc_shm_layout)) != 0)
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+    void *memory = mmap(nullptr, sizeof(clc_shm_layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+    lock_fd = fd;
+
+    /// a segment left by a crashed clc may have readers mid-read , so this goes through seq too
+    shm = static_cast<clc_shm_layout *>(memory);
+    uint32_t seq = shm->seq.load(std::memory_order_relaxed) | 1;
+    shm->seq.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(shm->magic, clc_shm_magic, sizeof(shm->magic));
+    shm->count = 0;
+    shm->writer_pid = int32_t(getpid());
+    shm->alive = 1;
+    shm->updated_ns = monotonic_now();
+    shm->seq.store(seq + 1, std::memory_order_release);
+    return true;
+}
+
+void shm_export::close()
+{
+    if(shm == nullptr)
+    {
+        return;
+    }
+    uint32_t seq = shm->seq.load(std::memory_order_relaxed);
+    shm->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    shm->alive = 0;
+    shm->updated_ns = monotonic_now();
+    shm->seq.store(seq + 2, std::memory_order_release);
+
+    munmap(shm, sizeof(clc_shm_layout));
+    shm = nullptr;
+    /// unlinked while still locked , so it can't pull the segment from under a clc that just took over
+    shm_unlink(shm_name);
+    ::close(lock_fd);
+    lock_fd = -1;
+}
+
+void shm_export::update(size_t index , const stopwatch &state , const char *name)
+{
+    if(shm == nullptr || index >= clc_shm_max_timers)
+    {
+        return;
+    }
+
+    /// clc_clock may be raw , coarse , tsc or boottime , readers only have CLOCK_MONOTONIC
+    int64_t mono_ns = monotonic_now();
+    int64_t start_ns = state.start_time.time_since_epoch().count();
+    if(!clock_is_monotonic())
+    {
+        start_ns += mono_ns - clock_now_ns();
+    }
+
+    uint32_t seq = shm->seq.load(std::memory_order_relaxed);
+    shm->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    clc_shm_timer &timer = shm->timers[index];
+    timer.saved_ns = state.saved.count();
+    timer.start_ns = start_ns;
+    timer.target_ns = state.target.count();
+    timer.running = state.running ? 1 : 0;
+    snprintf(timer.name, sizeof(timer.name), "%s", name);
+    if(index >= shm->count)
+    {
+        shm->count = uint32_t(index + 1);
+    }
+    shm->updated_ns = mono_ns;
+
+    shm->seq.store(seq + 2, std::memory_order_release);
+}
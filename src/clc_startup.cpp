@@ -0,0 +1,138 @@
+#include "../include/clc_startup.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+namespace
+{
+    int64_t boottime_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    int64_t monotonic_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    /// CLOCK_MONOTONIC ns the launcher (bench/clc_launch) took right before exec , moved onto
+    /// the CLOCK_BOOTTIME line . 0 when it's missing or not a time before now
+    int64_t launcher_exec_ns(int64_t now_boottime)
+    {
+        const char *stamp = getenv("CLC_EXEC_NS");
+        if(stamp == nullptr)
+        {
+            return 0;
+        }
+        char *end = nullptr;
+        long long exec_monotonic = strtoll(stamp, &end, 10);
+        /// only meant for this process , clc's own children mustn't see it
+        unsetenv("CLC_EXEC_NS");
+        int64_t now_monotonic = monotonic_ns();
+        if(end == stamp || *end != '\0' || exec_monotonic <= 0 || exec_monotonic > now_monotonic)
+        {
+            return 0;
+        }
+        return now_boottime - (now_monotonic - exec_monotonic);
+    }
+
+    /// field 22 of /proc/self/stat is the start time in clock ticks since boot
+    int64_t process_start_ns()
+    {
+        FILE *stat_file = fopen("/proc/self/stat", "r");
+        if(stat_file == nullptr)
+        {
+            return 0;
+        }
+        char line[1024];
+        size_t len = fread(line, 1, sizeof(line) - 1, stat_file);
+        fclose(stat_file);
+        line[len] = '\0';
+
+        /// the command name can hold spaces , fields count from the last ')'
+        char *cursor = strrchr(line, ')');
+        if(cursor == nullptr)
+        {
+            return 0;
+        }
+        unsigned long long start_ticks = 0;
+        int field = 2;
+        for (char *token = strtok(cursor + 1, " "); token != nullptr; token = strtok(nullptr, " "))
+        {
+            if(++field == 22)
+            {
+                start_ticks = strtoull(token, nullptr, 10);
+                break;
+            }
+        }
+        long ticks_per_sec = sysconf(_SC_CLK_TCK);
+        if(start_ticks == 0 || ticks_per_sec <= 0)
+        {
+            return 0;
+        }
+        return int64_t(start_ticks) * (1000000000 / ticks_per_sec);
+    }
+}
+
+void startup_timer::begin(bool requested)
+{
+    const char *env = getenv("CLC_STARTUP_TIMES");
+    enabled = requested || (env != nullptr && env[0] != '\0' && env[0] != '0');
+    if(!enabled)
+    {
+        return;
+    }
+    int64_t now = boottime_ns();
+    exec_ns = launcher_exec_ns(now);
+    if(exec_ns == 0)
+    {
+        exec_ns = process_start_ns();
+    }
+    if(exec_ns == 0 || exec_ns > now)
+    {
+        exec_ns = now;
+    }
+    count = 0;
+    phases[count++] = {"exec -> main", now};
+}
+
+void startup_timer::mark(const char *phase_name)
+{
+    if(!enabled || count == max_phases)
+    {
+        return;
+    }
+    phases[count++] = {phase_name, boottime_ns()};
+}
+
+double startup_timer::total_ms() const
+{
+    if(!enabled || count == 0)
+    {
+        return -1;
+    }
+    return double(phases[count - 1].end_ns - exec_ns) / 1e6;
+}
+
+void startup_timer::report() const
+{
+    if(!enabled)
+    {
+        return;
+    }
+    int64_t previous = exec_ns;
+    for (size_t i = 0; i < count; i++)
+    {
+        printf("clc. startup : %-20s %9.3f ms   (total %9.3f ms)\n", phases[i].name,
+               double(phases[i].end_ns - previous) / 1e6, double(phases[i].end_ns - exec_ns) / 1e6);
+        previous = phases[i].end_ns;
+    }
+    fflush(stdout);
+}
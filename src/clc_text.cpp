@@ -0,0 +1,502 @@
+#include "../include/clc_text.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/clc_persist.h"
+
+namespace
+{
+    const char text_vertex_src[] = R"(#version 330 core
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec2 uv;
+uniform vec2 view;
+out vec2 frag_uv;
+void main()
+{
+    frag_uv = uv;
+    gl_Position = vec4(pos.x / view.x * 2.0 - 1.0, 1.0 - pos.y / view.y * 2.0, 0.0, 1.0);
+}
+)";
+
+    const char text_fragment_src[] = R"(#version 330 core
+in vec2 frag_uv;
+uniform sampler2D atlas;
+uniform vec4 color;
+out vec4 out_color;
+void main()
+{
+    out_color = vec4(color.rgb, color.a * texture(atlas, frag_uv).r);
+}
+)";
+
+    /// cells are big on purpose : we don't know glyph's baseline convention ,
+    /// so the draw point sits in the middle and the real ink box is measured afterwards
+    float cell_width(float font_size) { return font_size * 1.0f; }
+    float cell_height(float font_size) { return font_size * 2.5f; }
+}
+
+constexpr const char text_layer::dynamic_chars[];
+
+void text_layer::atlas_size_for(float font_size , size_t static_count , int &width , int &height)
+{
+    width = 1;
+    while(width < int(cell_width(font_size) * float(sizeof(dynamic_chars) - 1)))
+    {
+        width *= 2;
+    }
+    width = std::max(width, 2048); /// static strings get a whole row
+    height = 1;
+    int needed = int(cell_height(font_size) * float(1 + static_count));
+    while(height < needed)
+    {
+        height *= 2;
+    }
+}
+
+/// shader and vertex buffer , same for a fresh atlas and a cached one
+bool text_layer::init_gpu_objects(size_t static_count)
+{
+    program = clc_gl_program(text_vertex_src, text_fragment_src);
+    if(program == 0)
+    {
+        return false;
+    }
+    color_location = clc_gl.GetUniformLocation(program, "color");
+    view_location = clc_gl.GetUniformLocation(program, "view");
+
+    quads.assign(static_count + dynamic_lines * max_dynamic, quad {});
+    lines = {};
+
+    clc_gl.GenVertexArrays(1, &vao);
+    clc_gl.GenBuffers(1, &vbo);
+    clc_gl.BindVertexArray(vao);
+    clc_gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+    clc_gl.BufferData(GL_ARRAY_BUFFER, GLsizeiptr(quads.size() * sizeof(quad)), quads.data(), GL_DYNAMIC_DRAW);
+    clc_gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *)0);
+    clc_gl.EnableVertexAttribArray(0);
+    clc_gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *)(2 * sizeof(float)));
+    clc_gl.EnableVertexAttribArray(1);
+    clc_gl.BindVertexArray(0);
+    return true;
+}
+
+bool text_layer::create(float font_size , float view_width , float view_height , const std::vector<const char *> &static_texts , draw_text_fn draw_text , void *ctx , const std::filesystem::path &cache_path , uint64_t cache_key)
+{
+    view_w = view_width;
+    view_h = view_height;
+    atlas_size_for(font_size, static_texts.size(), atlas_w, atlas_h);
+
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas_w, atlas_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    GLuint fbo = 0;
+    clc_gl.GenFramebuffers(1, &fbo);
+    clc_gl.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+    clc_gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas, 0);
+    if(clc_gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("clc. massage [error] : text atlas framebuffer is not complete\n");
+        clc_gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        clc_gl.DeleteFramebuffers(1, &fbo);
+        return false;
+    }
+
+    GLint old_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, old_viewport);
+    glViewport(0, 0, atlas_w, atlas_h);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    /// white glyphs on black : red channel ends up as coverage
+    const float cell_w = cell_width(font_size);
+    const float cell_h = cell_height(font_size);
+    const float pad = font_size * 0.1f;
+    char one_char[2] {0, 0};
+    for (size_t i = 0; i < dynamic_boxes.size(); i++)
+    {
+        one_char[0] = dynamic_chars[i];
+        draw_text(ctx, one_char, float(i) * cell_w + pad, cell_h * 0.5f);
+    }
+    for (size_t i = 0; i < static_texts.size(); i++)
+    {
+        draw_text(ctx, static_texts[i], pad, cell_h * (float(i) + 1.5f));
+    }
+
+    std::vector<unsigned char> pixels(size_t(atlas_w) * size_t(atlas_h) * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, atlas_w, atlas_h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    clc_gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    clc_gl.DeleteFramebuffers(1, &fbo);
+    glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+
+    /// ink box of a cell , the pixel rows are bottom up and the virtual space is top down
+    auto measure = [&](float left , float top , float width , float draw_x , float draw_y) {
+        glyph_box box;
+        int min_x = atlas_w , max_x = -1 , min_y = atlas_h , max_y = -1;
+        int x_begin = std::max(0, int(left)) , x_end = std::min(atlas_w, int(left + width));
+        int y_begin = std::max(0, int(top)) , y_end = std::min(atlas_h, int(top + cell_h));
+        for (int y = y_begin; y < y_end; y++)
+        {
+            const unsigned char *row = &pixels[size_t(atlas_h - 1 - y) * size_t(atlas_w) * 4];
+            for (int x = x_begin; x < x_end; x++)
+            {
+                if(row[x * 4] != 0)
+                {
+                    min_x = std::min(min_x, x);
+                    max_x = std::max(max_x, x);
+                    min_y = std::min(min_y, y);
+                    max_y = std::max(max_y, y);
+                }
+            }
+        }
+        if(max_x < 0)
+        {
+            box.advance = font_size * 0.3f;
+            return box;
+        }
+        box.x0 = float(min_x) - draw_x;
+        box.x1 = float(max_x + 1) - draw_x;
+        box.y0 = float(min_y) - draw_y;
+        box.y1 = float(max_y + 1) - draw_y;
+        box.u0 = float(min_x) / float(atlas_w);
+        box.u1 = float(max_x + 1) / float(atlas_w);
+        box.v0 = 1.0f - float(min_y) / float(atlas_h);
+        box.v1 = 1.0f - float(max_y + 1) / float(atlas_h);
+        box.advance = box.x1 + pad * 0.5f;
+        return box;
+    };
+
+    /// digits get one shared advance so the time doesn't wobble while it counts
+    float digit_advance = 0;
+    for (size_t i = 0; i < dynamic_boxes.size(); i++)
+    {
+        dynamic_boxes[i] = measure(float(i) * cell_w, 0, cell_w, float(i) * cell_w + pad, cell_h * 0.5f);
+        if(dynamic_chars[i] >= '0' && dynamic_chars[i] <= '9')
+        {
+            digit_advance = std::max(digit_advance, dynamic_boxes[i].advance);
+        }
+    }
+    for (size_t i = 0; i < dynamic_boxes.size(); i++)
+    {
+        if(dynamic_chars[i] >= '0' && dynamic_chars[i] <= '9')
+        {
+            dynamic_boxes[i].advance = digit_advance;
+        }
+    }
+
+    static_boxes.clear();
+    for (size_t i = 0; i < static_texts.size(); i++)
+    {
+        float top = cell_h * float(i + 1);
+        static_boxes.push_back(measure(0, top, float(atlas_w), pad, top + cell_h * 0.5f));
+    }
+
+    if(!cache_path.empty())
+    {
+        std::vector<unsigned char> coverage(size_t(atlas_w) * size_t(atlas_h));
+        for (size_t i = 0; i < coverage.size(); i++)
+        {
+            coverage[i] = pixels[i * 4];
+        }
+        save_cache(cache_path, cache_key, font_size, coverage);
+    }
+
+    return init_gpu_objects(static_texts.size());
+}
+
+/// atlas cache file : header , dynamic boxes , static boxes , then one byte of coverage per
+/// texel in gl row order (bottom up) so it goes straight into glTexImage2D
+namespace
+{
+    struct atlas_cache_header
+    {
+        char magic[8];
+        uint64_t key;
+        int32_t width;
+        int32_t height;
+        uint32_t dynamic_count;
+        uint32_t static_count;
+        uint32_t box_size;
+        float font_size;
+    };
+
+    constexpr char atlas_cache_magic[8] {'c', 'l', 'c', 'a', 't', 'l', '2', '\0'};
+}
+
+bool text_layer::save_cache(const std::filesystem::path &path , uint64_t key , float font_size , const std::vector<unsigned char> &coverage) const
+{
+    atlas_cache_header header {};
+    std::memcpy(header.magic, atlas_cache_magic, sizeof(header.magic));
+    header.key = key;
+    header.width = atlas_w;
+    header.height = atlas_h;
+    header.dynamic_count = uint32_t(dynamic_boxes.size());
+    header.static_count = uint32_t(static_boxes.size());
+    header.box_size = sizeof(glyph_box);
+    header.font_size = font_size;
+
+    std::vector<char> file(sizeof(header) + (dynamic_boxes.size() + static_boxes.size()) * sizeof(glyph_box) + coverage.size());
+    char *cursor = file.data();
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    std::memcpy(cursor, dynamic_boxes.data(), dynamic_boxes.size() * sizeof(glyph_box));
+    cursor += dynamic_boxes.size() * sizeof(glyph_box);
+    std::memcpy(cursor, static_boxes.data(), static_boxes.size() * sizeof(glyph_box));
+    cursor += static_boxes.size() * sizeof(glyph_box);
+    std::memcpy(cursor, coverage.data(), coverage.size());
+
+    return write_file_atomic(path, file.data(), file.size(), false);
+}
+
+bool text_layer::load_cache(const std::filesystem::path &path , uint64_t key , float view_width , float view_height , size_t static_count)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(atlas_cache_header))
+    {
+        close(fd);
+        return false;
+    }
+    size_t size = size_t(info.st_size);
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const char *data = static_cast<const char *>(mapped);
+    atlas_cache_header header;
+    std::memcpy(&header, data, sizeof(header));
+    size_t boxes_size = (size_t(header.dynamic_count) + header.static_count) * sizeof(glyph_box);
+    bool valid = std::memcmp(header.magic, atlas_cache_magic, sizeof(header.magic)) == 0
+        && header.key == key
+        && header.box_size == sizeof(glyph_box)
+        && header.dynamic_count == dynamic_boxes.size()
+        && header.static_count == static_count
+        && header.width > 0 && header.height > 0
+        && size == sizeof(header) + boxes_size + size_t(header.width) * size_t(header.height);
+    if(!valid)
+    {
+        munmap(mapped, size);
+        return false;
+    }
+
+    view_w = view_width;
+    view_h = view_height;
+    atlas_w = header.width;
+    atlas_h = header.height;
+
+    const char *cursor = data + sizeof(header);
+    std::memcpy(dynamic_boxes.data(), cursor, dynamic_boxes.size() * sizeof(glyph_box));
+    cursor += dynamic_boxes.size() * sizeof(glyph_box);
+    static_boxes.resize(static_count);
+    std::memcpy(static_boxes.data(), cursor, static_count * sizeof(glyph_box));
+    cursor += static_count * sizeof(glyph_box);
+
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas_w, atlas_h, 0, GL_RED, GL_UNSIGNED_BYTE, cursor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    munmap(mapped, size);
+
+    return init_gpu_objects(static_count);
+}
+
+uint64_t text_layer::cache_key(const char *font_path , float font_size , const std::vector<const char *> &static_texts)
+{
+    int fd = open(font_path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return 0;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return 0;
+    }
+    size_t size = size_t(info.st_size);
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    /// fnv-1a over the font , then the size and every string that ends up in the atlas
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void *bytes , size_t len) {
+        const unsigned char *p = static_cast<const unsigned char *>(bytes);
+        for (size_t i = 0; i < len; i++)
+        {
+            hash ^= p[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+    mix(mapped, size);
+    munmap(mapped, size);
+
+    mix(&font_size, sizeof(font_size));
+    mix(dynamic_chars, sizeof(dynamic_chars));
+    for (const char *text : static_texts)
+    {
+        mix(text, std::strlen(text) + 1);
+    }
+    return hash;
+}
+
+void text_layer::destroy()
+{
+    if(vbo) clc_gl.DeleteBuffers(1, &vbo);
+    if(vao) clc_gl.DeleteVertexArrays(1, &vao);
+    if(atlas) glDeleteTextures(1, &atlas);
+    if(program) clc_gl.DeleteProgram(program);
+    vbo = vao = atlas = program = 0;
+}
+
+text_layer::quad text_layer::make_quad(const glyph_box &box , float x , float y , float scale)
+{
+    vertex top_left {x + box.x0 * scale, y + box.y0 * scale, box.u0, box.v0};
+    vertex top_right {x + box.x1 * scale, y + box.y0 * scale, box.u1, box.v0};
+    vertex bottom_left {x + box.x0 * scale, y + box.y1 * scale, box.u0, box.v1};
+    vertex bottom_right {x + box.x1 * scale, y + box.y1 * scale, box.u1, box.v1};
+    return quad {top_left, bottom_left, top_right, top_right, bottom_left, bottom_right};
+}
+
+void text_layer::upload(size_t first_quad , size_t count)
+{
+    clc_gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+    clc_gl.BufferSubData(GL_ARRAY_BUFFER, GLintptr(first_quad * sizeof(quad)), GLsizeiptr(count * sizeof(quad)), &quads[first_quad]);
+}
+
+void text_layer::place_static(size_t index , float x , float y)
+{
+    quads[index] = make_quad(static_boxes[index], x, y);
+    upload(index, 1);
+}
+
+void text_layer::set_dynamic(size_t line , const char *text , size_t len , float x , float y , float scale)
+{
+    if(line >= dynamic_lines)
+    {
+        return;
+    }
+    dynamic_line &current = lines[line];
+    len = std::min(len, max_dynamic);
+    /// a line that moved up or down (or got resized) has every quad stale
+    const bool moved = current.y != y || current.scale != scale;
+    current.y = y;
+    current.scale = scale;
+    const size_t base = static_boxes.size() + line * max_dynamic;
+
+    /// upload one contiguous range that covers every changed slot
+    size_t first_changed = max_dynamic , last_changed = 0;
+    float pen = x;
+    for (size_t i = 0; i < len; i++)
+    {
+        const char *found = std::strchr(dynamic_chars, text[i]);
+        if(moved || i >= current.len || current.shown[i] != text[i] || current.shown_x[i] != pen)
+        {
+            quads[base + i] = (found && text[i] != '\0') ? make_quad(dynamic_boxes[found - dynamic_chars], pen, y, scale) : quad {};
+            current.shown[i] = text[i];
+            current.shown_x[i] = pen;
+            first_changed = std::min(first_changed, i);
+            last_changed = i;
+        }
+        if(found && text[i] != '\0')
+        {
+            pen += dynamic_boxes[found - dynamic_chars].advance * scale;
+        }
+        else if(text[i] == ' ')
+        {
+            pen += dynamic_boxes[0].advance * scale;
+        }
+    }
+    /// a shorter string leaves zero area quads behind , they draw nothing
+    for (size_t i = len; i < current.len; i++)
+    {
+        quads[base + i] = quad {};
+        first_changed = std::min(first_changed, i);
+        last_changed = i;
+    }
+    if(first_changed < max_dynamic)
+    {
+        upload(base + first_changed, last_changed - first_changed + 1);
+    }
+    current.len = len;
+}
+
+void text_layer::set_dynamic_color(size_t line , float r , float g , float b , float a)
+{
+    if(line >= dynamic_lines)
+    {
+        return;
+    }
+    lines[line].own_color = true;
+    lines[line].color = {r, g, b, a};
+}
+
+void text_layer::clear_dynamic_color(size_t line)
+{
+    if(line >= dynamic_lines)
+    {
+        return;
+    }
+    lines[line].own_color = false;
+}
+
+void text_layer::draw(float r , float g , float b , float a)
+{
+    clc_gl.UseProgram(program);
+    clc_gl.Uniform2f(view_location, view_w, view_h);
+    clc_gl.Uniform4f(color_location, r, g, b, a);
+    clc_gl.ActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    clc_gl.BindVertexArray(vao);
+    /// quads up to a line with its own color go out in one call , then that line alone
+    size_t first = 0;
+    for (size_t line = 0; line < dynamic_lines; line++)
+    {
+        const dynamic_line &current = lines[line];
+        if(!current.own_color)
+        {
+            continue;
+        }
+        const size_t base = static_boxes.size() + line * max_dynamic;
+        if(base > first)
+        {
+            glDrawArrays(GL_TRIANGLES, GLint(first * 6), GLsizei((base - first) * 6));
+        }
+        clc_gl.Uniform4f(color_location, current.color[0], current.color[1], current.color[2], current.color[3]);
+        glDrawArrays(GL_TRIANGLES, GLint(base * 6), GLsizei(max_dynamic * 6));
+        clc_gl.Uniform4f(color_location, r, g, b, a);
+        first = base + max_dynamic;
+    }
+    if(quads.size() > first)
+    {
+        glDrawArrays(GL_TRIANGLES, GLint(first * 6), GLsizei((quads.size() - first) * 6));
+    }
+    clc_gl.BindVertexArray(0);
+    clc_gl.UseProgram(0);
+}
@@ -0,0 +1,338 @@
+#include "../include/clc_tty.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "../include/clc_format.h"
+
+namespace
+{
+    /// a terminal over ssh doesn't need the 1ms steps the window uses
+    constexpr int tty_min_frame_ms = 33;
+
+    /// one row per timer from row 2 : "> <time>  running  <name>" padded so shorter strings wipe longer ones
+    constexpr size_t line_width = 48;
+    using tty_line = std::array<char, line_width>;
+
+    /// lap list under the help line , newest on top
+    constexpr size_t lap_rows = 5;
+
+    struct out_buffer
+    {
+        char data[8192];
+        size_t len = 0;
+
+        void add(const char *text , size_t count)
+        {
+            count = std::min(count, sizeof(data) - len);
+            std::memcpy(data + len, text, count);
+            len += count;
+        }
+
+        void add(const char *text)
+        {
+            add(text, std::strlen(text));
+        }
+
+        void move_to(int row , int column)
+        {
+            char escape[24];
+            int count = snprintf(escape, sizeof(escape), "\x1b[%d;%dH", row, column);
+            add(escape, size_t(count));
+        }
+
+        void flush()
+        {
+            size_t written = 0;
+            while(written < len)
+            {
+                ssize_t result = write(STDOUT_FILENO, data + written, len - written);
+                if(result <= 0)
+                {
+                    break;
+                }
+                written += size_t(result);
+            }
+            len = 0;
+        }
+    };
+
+    void draw_frame(out_buffer &out , size_t timer_count)
+    {
+        out.add("\x1b[2J");
+        out.move_to(1, 1);
+        out.add("clc.");
+        out.move_to(int(timer_count) + 3, 1);
+        out.add("space start/stop   r reset   l lap   up/down scroll laps   tab/1-9 pick   n new   q quit");
+    }
+
+    /// one cursor move per run of changed characters
+    void draw_row(out_buffer &out , int row , const tty_line &line , tty_line &old , bool full)
+    {
+        size_t i = 0;
+        while(i < line_width)
+        {
+            if(!full && line[i] == old[i])
+            {
+                i++;
+                continue;
+            }
+            /// one cursor move per run of changed cells , the scan goes on right after it
+            size_t run_end = i;
+            while(run_end < line_width && (full || line[run_end] != old[run_end]))
+            {
+                run_end++;
+            }
+            out.move_to(row, int(i) + 1);
+            out.add(line.data() + i, run_end - i);
+            i = run_end;
+        }
+        old = line;
+    }
+
+    /// the mode the terminal had before run_tty , for the checkpointer's exit hook : a signal ends
+    /// clc from the worker thread without returning here
+    termios saved_mode {};
+    bool saved_is_terminal = false;
+
+    void restore_terminal()
+    {
+        static const char show_cursor[] = "\x1b[?25h\r\n";
+        ssize_t ignored = write(STDOUT_FILENO, show_cursor, sizeof(show_cursor) - 1);
+        (void)ignored;
+        if(saved_is_terminal)
+        {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_mode);
+        }
+    }
+
+    void set_state(stopwatch_set &timers , size_t index , stopwatch state , journal_event event , checkpointer &saver)
+    {
+        timers.put(index, state);
+        saver.publish(index, state, event, timers.names[index].c_str());
+    }
+}
+
+int run_tty(stopwatch_set &timers , lap_ring &laps , checkpointer &saver , std::mutex &lock , int wake_fd , alarm_timer &alarms)
+{
+    termios old_mode {};
+    bool is_terminal = tcgetattr(STDIN_FILENO, &old_mode) == 0;
+    if(is_terminal)
+    {
+        /// keys one by one , no echo , ctrl+c comes in as a byte so we can save on it
+        termios raw_mode = old_mode;
+        raw_mode.c_lflag &= ~tcflag_t(ICANON | ECHO | ISIG);
+        raw_mode.c_cc[VMIN] = 0;
+        raw_mode.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw_mode);
+    }
+    saved_mode = old_mode;
+    saved_is_terminal = is_terminal;
+    saver.set_exit_hook(restore_terminal);
+
+    out_buffer out;
+    out.add("\x1b[?25l");
+
+    std::vector<tty_line> shown;
+    bool first_frame = true;
+    size_t lap_scroll = 0;
+
+    /// poll skips fds that are -1
+    pollfd fds[3] {{STDIN_FILENO, POLLIN, 0}, {wake_fd, POLLIN, 0}, {alarms.fd(), POLLIN, 0}};
+    pollfd &input = fds[0];
+    int wait_ms = 0;
+    bool quit = false;
+    while(!quit)
+    {
+        int ready = poll(fds, 3, wait_ms);
+        if(ready > 0 && (fds[1].revents & POLLIN))
+        {
+            uint64_t count;
+            ssize_t ignored = read(wake_fd, &count, sizeof(count));
+            (void)ignored;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        if(ready > 0 && (fds[2].revents & POLLIN) && alarms.take_due())
+        {
+            size_t expired[stopwatch_set::max_timers];
+            size_t expired_count = alarms.expire(timers, clc_clock::now(), expired);
+            for (size_t i = 0; i < expired_count; i++)
+            {
+                saver.publish(expired[i], timers.get(expired[i]), journal_event::stop, timers.names[expired[i]].c_str());
+                saver.log("clc. massage [alert] : %s is up", timers.names[expired[i]].c_str());
+            }
+            if(expired_count != 0)
+            {
+                out.add("\a");
+            }
+        }
+        if(ready > 0 && (input.revents & (POLLIN | POLLHUP)))
+        {
+            char keys[64];
+            ssize_t count = read(STDIN_FILENO, keys, sizeof(keys));
+            if(count <= 0)
+            {
+                /// stdin closed (not a terminal) , keep counting without input
+                input.fd = -1;
+            }
+            for (ssize_t i = 0; i < count; i++)
+            {
+                char key = keys[i];
+                stopwatch active = timers.get(timers.active);
+                if(key == ' ')
+                {
+                    active.toggle(clc_clock::now());
+                    set_state(timers, timers.active, active, active.running ? journal_event::start : journal_event::stop, saver);
+                }
+                else if(key == 'r')
+                {
+                    active.reset(clc_clock::now());
+                    set_state(timers, timers.active, active, journal_event::reset, saver);
+                    laps.reset_timer(timers.active);
+                }
+                else if(key == 'l' && active.running)
+                {
+                    clc_clock::time_point now = clc_clock::now();
+                    laps.push(timers.active, active.elapsed(now).count(), now.time_since_epoch().count());
+                    lap_scroll = 0;
+                }
+                else if(key == '\t')
+                {
+                    timers.active = (timers.active + 1) % timers.size();
+                }
+                else if(key >= '1' && key <= '9' && size_t(key - '1') < timers.size())
+                {
+                    timers.active = size_t(key - '1');
+                }
+                else if(key == 'n')
+                {
+                    size_t index = timers.add("timer " + std::to_string(timers.size() + 1));
+                    if(index != stopwatch_set::max_timers)
+                    {
+                        timers.active = index;
+                        set_state(timers, index, timers.get(index), journal_event::checkpoint, saver);
+                    }
+                }
+                else if(key == 'q' || key == 3)
+                {
+                    quit = true;
+                }
+                else if(key == 27 && i + 2 < count && keys[i + 1] == '[')
+                {
+                    /// arrows come as esc [ A / esc [ B
+                    if(keys[i + 2] == 'A' && lap_scroll != 0)
+                    {
+                        lap_scroll--;
+                    }
+                    else if(keys[i + 2] == 'B')
+                    {
+                        lap_scroll++;
+                    }
+                    i += 2;
+                }
+                else if(key == 27)
+                {
+                    /// a lone esc is a key , esc followed by more bytes is something we don't know
+                    quit = i == count - 1;
+                    break;
+                }
+            }
+        }
+
+        /// keys and control commands both land before here
+        alarms.arm(timers);
+
+        if(shown.size() != timers.size() + lap_rows)
+        {
+            /// a new timer (key or control socket) moves the help line and the laps down a row
+            draw_frame(out, timers.size());
+            first_frame = true;
+        }
+        clc_clock::time_point now = clc_clock::now();
+        shown.resize(timers.size() + lap_rows);
+        wait_ms = -1;
+        for (size_t t = 0; t < timers.size(); t++)
+        {
+            int64_t time_ns = timers.shown_ns(t, now);
+            const bool counting_down = timers.target_ns[t] != 0;
+            t_str_buf time_str;
+            size_t time_len = t_str_fucn(time_ns, time_str);
+
+            tty_line line;
+            line.fill(' ');
+            line[0] = t == timers.active ? '>' : ' ';
+            std::memcpy(line.data() + 2, time_str.data(), time_len);
+            const char *state = timers.running[t] ? "running" : counting_down && time_ns == 0 ? "done" : "paused";
+            std::memcpy(line.data() + 12, state, std::strlen(state));
+            const std::string &name = timers.names[t];
+            std::memcpy(line.data() + 21, name.data(), std::min(name.size(), line_width - 21));
+            draw_row(out, int(t) + 2, line, shown[t], first_frame);
+
+            if(timers.running[t])
+            {
+                int next = std::max(next_redraw_ms(time_ns, counting_down), tty_min_frame_ms);
+                wait_ms = wait_ms < 0 ? next : std::min(wait_ms, next);
+            }
+        }
+
+        const lap_entry *visible[lap_rows];
+        size_t found = laps.newest_of(timers.active, lap_scroll, visible, lap_rows);
+        if(found == 0 && lap_scroll != 0)
+        {
+            lap_scroll--;
+            found = laps.newest_of(timers.active, lap_scroll, visible, lap_rows);
+        }
+        for (size_t i = 0; i < lap_rows; i++)
+        {
+            tty_line line;
+            line.fill(' ');
+            if(i < found)
+            {
+                lap_str_buf lap_str;
+                size_t lap_len = lap_str_fucn(visible[i]->number, visible[i]->split_ns, lap_str);
+                std::memcpy(line.data() + 2, lap_str.data(), lap_len);
+                t_str_buf total_str;
+                size_t total_len = t_str_fucn(visible[i]->total_ns, total_str);
+                /// a lap number past 4 digits pushes the total right instead of being overwritten
+                std::memcpy(line.data() + std::max<size_t>(21, 2 + lap_len + 1), total_str.data(), total_len);
+            }
+            draw_row(out, int(timers.size() + 5 + i), line, shown[timers.size() + i], first_frame);
+        }
+
+        /// laps reach the checkpointer in batches , a lone one after lap_ring::flush_after_ns
+        if(laps.flush_due(now.time_since_epoch().count(), checkpointer::lap_batch))
+        {
+            saver.publish_laps(laps);
+        }
+        if(laps.pending() != 0)
+        {
+            constexpr int lap_wait_ms = int(lap_ring::flush_after_ns / 1000000);
+            wait_ms = wait_ms < 0 ? lap_wait_ms : std::min(wait_ms, lap_wait_ms);
+        }
+        first_frame = false;
+        guard.unlock();
+        out.flush();
+
+        if(input.fd < 0 && wake_fd < 0 && wait_ms < 0)
+        {
+            /// nothing can change anymore
+            break;
+        }
+    }
+
+    out.move_to(int(timers.size() + 5 + lap_rows), 1);
+    out.add("\x1b[?25h");
+    out.flush();
+    saver.set_exit_hook(nullptr);
+    if(is_terminal)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &old_mode);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "../include/clc_input.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <algorithm>
+
+bool key_stamper::open()
+{
+    Display *connection = XOpenDisplay(nullptr);
+    if(connection == nullptr)
+    {
+        return false;
+    }
+    int event , error;
+    int major = 2 , minor = 0;
+    if(!XQueryExtension(connection, "XInputExtension", &xi_opcode, &event, &error) || XIQueryVersion(connection, &major, &minor) != Success)
+    {
+        XCloseDisplay(connection);
+        return false;
+    }
+    display = connection;
+    select(true);
+    return true;
+}
+
+void key_stamper::close()
+{
+    if(display != nullptr)
+    {
+        XCloseDisplay(static_cast<Display *>(display));
+        display = nullptr;
+    }
+    pending_count = 0;
+}
+
+void key_stamper::select(bool on)
+{
+    Display *connection = static_cast<Display *>(display);
+    unsigned char mask[XIMaskLen(XI_LASTEVENT)] {};
+    if(on)
+    {
+        XISetMask(mask, XI_RawKeyPress);
+    }
+    XIEventMask events;
+    events.deviceid = XIAllMasterDevices;
+    events.mask_len = sizeof(mask);
+    events.mask = mask;
+    XISelectEvents(connection, DefaultRootWindow(connection), &events, 1);
+    XFlush(connection);
+}
+
+void key_stamper::set_focused(bool focused)
+{
+    if(display == nullptr)
+    {
+        return;
+    }
+    select(focused);
+    drain();
+    pending_count = 0;
+}
+
+void key_stamper::drain()
+{
+    Display *connection = static_cast<Display *>(display);
+    while(XPending(connection) > 0)
+    {
+        XEvent event;
+        XNextEvent(connection, &event);
+        XGenericEventCookie *cookie = &event.xcookie;
+        if(cookie->type != GenericEvent || cookie->extension != xi_opcode || !XGetEventData(connection, cookie))
+        {
+            continue;
+        }
+        if(cookie->evtype == XI_RawKeyPress)
+        {
+            const XIRawEvent *raw = static_cast<const XIRawEvent *>(cookie->data);
+            if(pending_count == max_pending)
+            {
+                /// nobody asked for the oldest one , a key rgfw doesn't report
+                std::copy(pending + 1, pending + max_pending, pending);
+                pending_count--;
+            }
+            pending[pending_count++] = press {uint32_t(raw->detail), uint32_t(raw->time)};
+        }
+        XFreeEventData(connection, cookie);
+    }
+}
+
+bool key_stamper::take_press(unsigned long keysym , int64_t now_ns , int64_t &press_ns)
+{
+    if(display == nullptr)
+    {
+        return false;
+    }
+    Display *connection = static_cast<Display *>(display);
+    uint32_t keycode = XKeysymToKeycode(connection, KeySym(keysym));
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        drain();
+        for (size_t i = 0; i < pending_count; i++)
+        {
+            if(pending[i].keycode == keycode)
+            {
+                uint32_t server_ms = pending[i].server_ms;
+                std::copy(pending + i + 1, pending + pending_count, pending + i);
+                pending_count--;
+                return server_ms_to_monotonic(server_ms, now_ns, press_ns);
+            }
+        }
+        /// rgfw's connection can be a little ahead of this one , one round trip brings it level
+        XSync(connection, False);
+    }
+    return false;
+}
@@ -0,0 +1,108 @@
+/// a burst of state changes bigger than the checkpointer's queue : every start and stop must
+/// reach the journal (the control socket can send thousands at once) , none may be dropped
+/// and after stop() the signals start() blocked are deliverable again . a SIGTERM exit keeps
+/// the laps still waiting in the ring (set_exit_laps)
+#include "../include/clc_journal.h"
+#include "../include/clc_persist.h"
+#include "clc_check.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+int main()
+{
+    char dir_template[] = "/tmp/clc-checkpointer-XXXXXX";
+    if(mkdtemp(dir_template) == nullptr)
+    {
+        printf("clc. test : can't make a temp dir\n");
+        return 1;
+    }
+    const fs::path dir = dir_template;
+
+    constexpr size_t runs = 20000; /// 40000 records , the queue holds 1024
+    journal events;
+    journal_summary summary;
+    CLC_CHECK(events.open(dir / "journal", 1 << 20, summary));
+    checkpointer saver;
+    CLC_CHECK(saver.start(dir / "lt", int64_t(60) * 1000000000, false, &events));
+
+    stopwatch state;
+    int64_t now_ns = 1000000000;
+    for (size_t i = 0; i < runs; i++)
+    {
+        state.start(clc_clock::time_point(duration_ns(now_ns)));
+        saver.publish(0, state, journal_event::start, "burst");
+        now_ns += 1000;
+        state.stop(clc_clock::time_point(duration_ns(now_ns)));
+        saver.publish(0, state, journal_event::stop, "burst");
+        now_ns += 1000;
+    }
+    CLC_CHECK(saver.flush());
+    saver.stop();
+    events.close();
+
+    /// start() blocked SIGINT / SIGTERM for its signalfd , stop() must hand them back
+    sigset_t mask;
+    pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+    CLC_CHECK(!sigismember(&mask, SIGINT));
+    CLC_CHECK(!sigismember(&mask, SIGTERM));
+
+    io_stats stats = saver.stats();
+    CLC_CHECK(stats.dropped == 0);
+    journal_summary replayed;
+    CLC_CHECK(journal_replay(dir / "journal", replayed));
+    CLC_CHECK(replayed.records == 2 * runs);
+    CLC_CHECK(replayed.runs == int64_t(runs));
+    CLC_CHECK(replayed.run_ns == int64_t(runs) * 1000);
+    printf("clc. test : %zu records , %llu waited for room\n", replayed.records, (unsigned long long)stats.waited);
+
+    /// the worker _Exits the process on SIGTERM , so that part runs in a child
+    constexpr size_t signal_laps = 5; /// under lap_batch , nothing would have sent them yet
+    fflush(stdout);
+    pid_t child = fork();
+    if(child == 0)
+    {
+        journal child_events;
+        journal_summary child_summary;
+        checkpointer child_saver;
+        auto laps = std::make_unique<lap_ring>();
+        std::mutex laps_lock;
+        if(!child_events.open(dir / "signal-journal", 1 << 20, child_summary)
+            || !child_saver.start(dir / "signal-lt", int64_t(60) * 1000000000, false, &child_events))
+        {
+            std::_Exit(1);
+        }
+        child_saver.set_exit_laps(laps.get(), &laps_lock);
+        stopwatch running;
+        running.start(clc_clock::time_point(duration_ns(0)));
+        child_saver.publish(0, running, journal_event::start, "laps");
+        {
+            std::lock_guard<std::mutex> guard(laps_lock);
+            for (size_t i = 0; i < signal_laps; i++)
+            {
+                laps->push(0, int64_t(i + 1) * 1000000, int64_t(i + 1) * 1000000);
+            }
+        }
+        kill(getpid(), SIGTERM);
+        while(true)
+        {
+            pause();
+        }
+    }
+    int status = 0;
+    CLC_CHECK(child > 0 && waitpid(child, &status, 0) == child);
+    CLC_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 128 + SIGTERM);
+    journal_summary signal_replayed;
+    CLC_CHECK(journal_replay(dir / "signal-journal", signal_replayed));
+    CLC_CHECK(signal_replayed.laps == int64_t(signal_laps));
+
+    std::error_code error;
+    fs::remove_all(dir, error);
+    return failures();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdio>
+
+/// no framework : a failed check prints where it was and the test's main returns failures()
+inline int &check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CLC_CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            printf("clc. test [fail] : %s:%d : %s\n", __FILE__, __LINE__, #condition); \
+            check_failures()++; \
+        } \
+    } while(0)
+
+inline int failures()
+{
+    if(check_failures() != 0)
+    {
+        printf("clc. test : %d check(s) failed\n", check_failures());
+    }
+    return check_failures() == 0 ? 0 : 1;
+}
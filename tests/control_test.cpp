@@ -0,0 +1,105 @@
+/// a client that pipelines commands and never reads : clc must stop reading it once
+/// max_pending_out of replies wait (its send blocks instead of clc's memory growing) ,
+/// and every command it got in still gets its reply once the client drains
+#include "../include/clc_control.h"
+#include "clc_check.h"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    stopwatch_set timers;
+    lap_ring laps;
+    checkpointer saver;
+    std::mutex state_lock;
+}
+
+int main()
+{
+    char dir_template[] = "/tmp/clc-control-XXXXXX";
+    if(mkdtemp(dir_template) == nullptr)
+    {
+        printf("clc. test : can't make a temp dir\n");
+        return 1;
+    }
+    const fs::path dir = dir_template;
+
+    control_server server;
+    CLC_CHECK(server.start(dir / "control", timers, laps, saver, state_lock, nullptr, nullptr));
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, (dir / "control").c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    CLC_CHECK(fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+
+    /// "count\n" answers "ok 1\n" , without the cap clc reads all 64 MiB and keeps the replies
+    constexpr size_t send_limit = size_t(64) << 20;
+    char lines[4092]; /// 682 lines
+    for (size_t i = 0; i < sizeof(lines); i += 6)
+    {
+        std::memcpy(lines + i, "count\n", 6);
+    }
+    size_t sent = 0;
+    bool blocked = false;
+    while(sent < send_limit)
+    {
+        ssize_t result = send(fd, lines, sizeof(lines), MSG_NOSIGNAL);
+        if(result > 0)
+        {
+            sent += size_t(result);
+            continue;
+        }
+        if(result < 0 && errno == EAGAIN)
+        {
+            /// clc may still be catching up , blocked for half a second means it stopped reading
+            pollfd wait {fd, POLLOUT, 0};
+            if(poll(&wait, 1, 500) == 0)
+            {
+                blocked = true;
+                break;
+            }
+            continue;
+        }
+        break;
+    }
+    CLC_CHECK(blocked);
+    CLC_CHECK(sent % 6 == 0);
+
+    /// now read : everything sent before the block gets answered , then clc closes at eof
+    shutdown(fd, SHUT_WR);
+    size_t replies = 0;
+    char buf[16384];
+    while(true)
+    {
+        pollfd wait {fd, POLLIN, 0};
+        if(poll(&wait, 1, 2000) <= 0)
+        {
+            break;
+        }
+        ssize_t result = read(fd, buf, sizeof(buf));
+        if(result <= 0)
+        {
+            break;
+        }
+        for (ssize_t i = 0; i < result; i++)
+        {
+            replies += buf[i] == '\n';
+        }
+    }
+    close(fd);
+    CLC_CHECK(replies == sent / 6);
+    printf("clc. test : %zu commands in before the block , %zu replies\n", sent / 6, replies);
+
+    server.stop();
+    std::error_code error;
+    fs::remove_all(dir, error);
+    return failures();
+}
@@ -0,0 +1,148 @@
+/// the clc clock , suspend policies , laps and countdown expiry driven by fake_clock , so every
+/// elapsed value is known to the ns . ends with random steps over every timer at once
+#include "../include/clc_alarm.h"
+#include "../include/clc_clock.h"
+#include "../include/clc_laps.h"
+#include "../include/clc_stopwatch.h"
+#include "clc_check.h"
+
+#include <memory>
+#include <random>
+
+namespace
+{
+    constexpr int64_t second = 1000000000;
+
+    fake_clock fake;
+
+    void start_stop_lap(suspend_policy policy)
+    {
+        CLC_CHECK(select_suspend_policy(policy));
+        const bool counts_sleep = policy == suspend_policy::count;
+        auto laps = std::make_unique<lap_ring>();
+        stopwatch_set timers;
+
+        stopwatch state = timers.get(0);
+        state.start(clc_clock::now());
+        timers.put(0, state);
+        fake.advance(2 * second);
+        const lap_entry &first = laps->push(0, timers.elapsed_ns(0, clc_clock::now()), clc_clock::now().time_since_epoch().count());
+        CLC_CHECK(first.total_ns == 2 * second);
+        CLC_CHECK(first.split_ns == 2 * second);
+
+        fake.advance(second);
+        fake.suspend(10 * second);
+        fake.advance(second);
+        int64_t expected_ns = counts_sleep ? 14 * second : 4 * second;
+        CLC_CHECK(timers.get(0).slept_ns() == 10 * second);
+        const lap_entry &second_lap = laps->push(0, timers.elapsed_ns(0, clc_clock::now()), clc_clock::now().time_since_epoch().count());
+        CLC_CHECK(second_lap.total_ns == expected_ns);
+        CLC_CHECK(second_lap.split_ns == expected_ns - 2 * second);
+        CLC_CHECK(second_lap.number == 2);
+
+        state = timers.get(0);
+        state.stop(clc_clock::now());
+        timers.put(0, state);
+        fake.advance(30 * second);
+        fake.suspend(30 * second);
+        CLC_CHECK(timers.elapsed_ns(0, clc_clock::now()) == expected_ns);
+        CLC_CHECK(timers.get(0).slept_ns() == 0);
+    }
+
+    void countdown_expiry(suspend_policy policy)
+    {
+        CLC_CHECK(select_suspend_policy(policy));
+        alarm_timer alarms; /// expire() only , no timerfd needed
+        stopwatch_set timers;
+        size_t index = timers.add("tea");
+        stopwatch state;
+        state.target = duration_ns(5 * second);
+        state.start(clc_clock::now());
+        timers.put(index, state);
+
+        size_t expired[stopwatch_set::max_timers];
+        fake.advance(3 * second);
+        CLC_CHECK(alarms.expire(timers, clc_clock::now(), expired) == 0);
+        CLC_CHECK(timers.shown_ns(index, clc_clock::now()) == 2 * second);
+
+        /// a suspend only runs a countdown down when it's counted
+        fake.suspend(second);
+        CLC_CHECK(timers.shown_ns(index, clc_clock::now()) == (policy == suspend_policy::count ? second : 2 * second));
+
+        /// handled late , still stops exactly at the deadline
+        fake.advance(2500000000);
+        CLC_CHECK(alarms.expire(timers, clc_clock::now(), expired) == 1);
+        CLC_CHECK(expired[0] == index);
+        CLC_CHECK(!timers.running[index]);
+        CLC_CHECK(timers.saved_ns[index] == 5 * second);
+        CLC_CHECK(timers.shown_ns(index, clc_clock::now()) == 0);
+        CLC_CHECK(timers.get(index).finished());
+        CLC_CHECK(alarms.expire(timers, clc_clock::now(), expired) == 0);
+
+        /// started again it counts down from the top
+        state = timers.get(index);
+        state.start(clc_clock::now());
+        timers.put(index, state);
+        fake.advance(second);
+        CLC_CHECK(timers.shown_ns(index, clc_clock::now()) == 4 * second);
+    }
+
+    /// every step moves the clock (awake or asleep) and flips a random timer , the model keeps
+    /// what each timer should read in plain integers
+    void random_steps(suspend_policy policy)
+    {
+        CLC_CHECK(select_suspend_policy(policy));
+        const bool counts_sleep = policy == suspend_policy::count;
+        stopwatch_set timers;
+        while(timers.size() < stopwatch_set::max_timers)
+        {
+            timers.add("t");
+        }
+        int64_t model[stopwatch_set::max_timers] {};
+        bool running[stopwatch_set::max_timers] {};
+
+        std::mt19937_64 random(policy == suspend_policy::count ? 2 : 1);
+        std::uniform_int_distribution<int64_t> step_ns(0, 3 * second);
+        std::uniform_int_distribution<size_t> pick(0, stopwatch_set::max_timers - 1);
+        int64_t all[stopwatch_set::max_timers];
+        size_t mismatches = 0;
+        for (size_t i = 0; i < 1000000; i++)
+        {
+            int64_t step = step_ns(random);
+            bool asleep = (random() & 15) == 0;
+            asleep ? fake.suspend(step) : fake.advance(step);
+            for (size_t t = 0; t < stopwatch_set::max_timers; t++)
+            {
+                model[t] += running[t] && (!asleep || counts_sleep) ? step : 0;
+            }
+
+            size_t t = pick(random);
+            stopwatch state = timers.get(t);
+            state.toggle(clc_clock::now());
+            timers.put(t, state);
+            running[t] = !running[t];
+
+            timers.elapsed_all(clc_clock::now(), all);
+            for (size_t k = 0; k < stopwatch_set::max_timers; k++)
+            {
+                mismatches += all[k] != model[k];
+            }
+        }
+        CLC_CHECK(mismatches == 0);
+    }
+}
+
+int main()
+{
+    fake.monotonic_ns = 1000 * second;
+    fake.boottime_ns = 1000 * second;
+    clock_install_fake(&fake);
+    for (suspend_policy policy : {suspend_policy::skip, suspend_policy::count})
+    {
+        start_stop_lap(policy);
+        countdown_expiry(policy);
+        random_steps(policy);
+    }
+    clock_uninstall_fake();
+    return failures();
+}
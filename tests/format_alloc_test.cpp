@@ -0,0 +1,92 @@
+/// the per-frame formatters never touch the heap : global new / delete are replaced by counting
+/// ones and t_str_fucn , lap_str_fucn and next_redraw_ms run over every digit layout
+#include "../include/clc_format.h"
+#include "clc_check.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace
+{
+    std::atomic<uint64_t> allocations {0};
+}
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    if(void *memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size , const std::nothrow_t &) noexcept
+{
+    allocations++;
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size , const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory , std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory , std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main()
+{
+    /// the counter itself works , or a 0 below proves nothing
+    uint64_t before = allocations;
+    {
+        std::string probe(100, 'x');
+        CLC_CHECK(probe.size() == 100);
+    }
+    CLC_CHECK(allocations - before == 1);
+
+    /// 1us steps near zero , then growing steps up past the 10h and 100h layouts
+    t_str_buf t_str;
+    lap_str_buf lap_str;
+    uint64_t calls = 0;
+    size_t total_len = 0;
+    before = allocations;
+    for (int64_t time_ns = 0; time_ns < int64_t(400) * 3600 * 1000000000; time_ns += 1000 + time_ns / 50000)
+    {
+        size_t len = t_str_fucn(time_ns, t_str);
+        total_len += len;
+        total_len += size_t(next_redraw_ms(time_ns));
+        total_len += size_t(next_redraw_ms(time_ns, true));
+        total_len += lap_str_fucn(uint32_t(calls), time_ns, lap_str);
+        calls++;
+    }
+    uint64_t allocated = allocations - before;
+    CLC_CHECK(allocated == 0);
+    CLC_CHECK(total_len != 0);
+    printf("clc. test : %llu calls of each formatter , %llu allocations\n", (unsigned long long)calls, (unsigned long long)allocated);
+    return failures();
+}
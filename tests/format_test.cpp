@@ -0,0 +1,72 @@
+/// next_redraw_ms against t_str_fucn itself : the shown string must stay the same until the
+/// returned ms and be different at it , in every layout from 0 to 400h (the 10h and 100h ones
+/// show whole or tens of seconds , no fraction) , and lap rows past 999
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../include/clc_format.h"
+#include "clc_check.h"
+
+namespace
+{
+    constexpr int64_t ns_in_ms = 1000000;
+    constexpr int64_t ns_in_hour = int64_t(3600) * 1000000000;
+
+    bool same_text(int64_t a_ns , int64_t b_ns)
+    {
+        t_str_buf a , b;
+        size_t a_len = t_str_fucn(a_ns, a);
+        size_t b_len = t_str_fucn(b_ns, b);
+        return a_len == b_len && std::memcmp(a.data(), b.data(), a_len) == 0;
+    }
+
+    /// counting up the text changes at time + ms , counting down at time - ms
+    void check_wait(int64_t time_ns , bool counting_down)
+    {
+        int64_t wait_ns = next_redraw_ms(time_ns, counting_down) * ns_in_ms;
+        int64_t direction = counting_down ? -1 : 1;
+        if(counting_down && time_ns - wait_ns < 0)
+        {
+            return; /// the countdown ends first , clc stops it there
+        }
+        CLC_CHECK(wait_ns > 0);
+        CLC_CHECK(same_text(time_ns, time_ns + direction * (wait_ns - ns_in_ms)));
+        CLC_CHECK(!same_text(time_ns, time_ns + direction * wait_ns));
+    }
+}
+
+int main()
+{
+    /// past 10h the last digit is the seconds , one wake a second and not every 10 ms
+    CLC_CHECK(next_redraw_ms(12 * ns_in_hour + (34 * 60 + 56) * int64_t(1000000000)) == 1000);
+    CLC_CHECK(next_redraw_ms(12 * ns_in_hour + (34 * 60 + 56) * int64_t(1000000000) + 250 * ns_in_ms) == 750);
+    /// "123.45.5" : tens of seconds
+    CLC_CHECK(next_redraw_ms(123 * ns_in_hour + (45 * 60 + 51) * int64_t(1000000000)) == 9000);
+    /// "1.2.0300" (minutes aren't zero padded) : 100us steps round up to the next ms
+    t_str_buf minute_str;
+    size_t minute_len = t_str_fucn(int64_t(62030) * ns_in_ms, minute_str);
+    CLC_CHECK(minute_len == 8 && std::strcmp(minute_str.data(), "1.2.0300") == 0);
+    CLC_CHECK(next_redraw_ms(int64_t(62030) * ns_in_ms) == 1);
+
+    /// lap numbers don't wrap at 1000 , past 4 digits the row gets wider
+    lap_str_buf lap_str;
+    size_t lap_len = lap_str_fucn(7, int64_t(1250) * ns_in_ms, lap_str);
+    CLC_CHECK(lap_len == 14 && std::strcmp(lap_str.data(), "   7  1.250000") == 0);
+    lap_len = lap_str_fucn(1000, int64_t(1250) * ns_in_ms, lap_str);
+    CLC_CHECK(lap_len == 14 && std::strcmp(lap_str.data(), "1000  1.250000") == 0);
+    lap_len = lap_str_fucn(4096, 0, lap_str);
+    CLC_CHECK(std::strncmp(lap_str.data(), "4096  ", 6) == 0);
+    lap_len = lap_str_fucn(UINT32_MAX, int64_t(1250) * ns_in_ms, lap_str);
+    CLC_CHECK(lap_len == 20 && std::strcmp(lap_str.data(), "4294967295  1.250000") == 0);
+
+    uint64_t cases = 0;
+    for (int64_t time_ns = 0; time_ns < 400 * ns_in_hour; time_ns += 999983 + time_ns / 20000)
+    {
+        check_wait(time_ns, false);
+        check_wait(time_ns, true);
+        cases++;
+    }
+    printf("clc. test : next_redraw_ms checked at %llu times\n", (unsigned long long)cases);
+    return failures();
+}
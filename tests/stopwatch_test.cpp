@@ -0,0 +1,102 @@
+/// stopwatch / stopwatch_set arithmetic : millions of start/stop cycles must add up to exactly
+/// the sum of the run lengths (the old double seconds drifted) , and reset while running
+#include "../include/clc_stopwatch.h"
+#include "clc_check.h"
+
+#include <random>
+
+namespace
+{
+    using time_point = clc_clock::time_point;
+
+    time_point at(int64_t ns)
+    {
+        return time_point(duration_ns(ns));
+    }
+
+    void drift()
+    {
+        constexpr size_t cycles = 5000000;
+        std::mt19937_64 random(0xC1C);
+        std::uniform_int_distribution<int64_t> run_ns(1, 5000000000);
+        std::uniform_int_distribution<int64_t> pause_ns(0, 1000000000);
+
+        stopwatch single;
+        stopwatch_set set;
+        set.add("second");
+        int64_t now_ns = 1000000000;
+        int64_t expected_ns = 0;
+        double seconds = 0.0; /// what clc used to keep , only reported
+        for (size_t i = 0; i < cycles; i++)
+        {
+            int64_t run = run_ns(random);
+            single.start(at(now_ns));
+            stopwatch in_set = set.get(1);
+            in_set.start(at(now_ns));
+            set.put(1, in_set);
+
+            /// halfway through the run the elapsed time must already be exact
+            CLC_CHECK(single.elapsed(at(now_ns + run / 2)).count() == expected_ns + run / 2);
+
+            now_ns += run;
+            single.stop(at(now_ns));
+            in_set = set.get(1);
+            in_set.stop(at(now_ns));
+            set.put(1, in_set);
+            expected_ns += run;
+            seconds += double(run) / 1e9;
+            now_ns += pause_ns(random);
+
+            if(single.elapsed(at(now_ns)).count() != expected_ns || set.elapsed_ns(1, at(now_ns)) != expected_ns)
+            {
+                CLC_CHECK(single.elapsed(at(now_ns)).count() == expected_ns);
+                CLC_CHECK(set.elapsed_ns(1, at(now_ns)) == expected_ns);
+                return;
+            }
+        }
+        int64_t all[2];
+        set.elapsed_all(at(now_ns), all);
+        CLC_CHECK(all[1] == expected_ns);
+        CLC_CHECK(all[0] == 0);
+        printf("clc. test : %zu cycles , %lld ns exact , doubles would be off by %.0f ns\n",
+               cycles, (long long)expected_ns, seconds * 1e9 - double(expected_ns));
+    }
+
+    void reset_while_running()
+    {
+        stopwatch watch;
+        watch.start(at(10000000000));
+        watch.stop(at(12000000000));
+        watch.start(at(20000000000));
+        CLC_CHECK(watch.elapsed(at(25000000000)).count() == 7000000000);
+
+        /// a running timer keeps running from zero
+        watch.reset(at(25000000000));
+        CLC_CHECK(watch.running);
+        CLC_CHECK(watch.elapsed(at(25000000000)).count() == 0);
+        CLC_CHECK(watch.elapsed(at(27500000000)).count() == 2500000000);
+        watch.stop(at(28000000000));
+        CLC_CHECK(watch.elapsed(at(40000000000)).count() == 3000000000);
+
+        /// a paused one stays paused at zero
+        watch.reset(at(41000000000));
+        CLC_CHECK(!watch.running);
+        CLC_CHECK(watch.elapsed(at(50000000000)).count() == 0);
+
+        /// same through the set
+        stopwatch_set set;
+        stopwatch state = set.get(0);
+        state.start(at(1000));
+        state.reset(at(5000));
+        set.put(0, state);
+        CLC_CHECK(set.running[0] == 1);
+        CLC_CHECK(set.elapsed_ns(0, at(8000)) == 3000);
+    }
+}
+
+int main()
+{
+    drift();
+    reset_while_running();
+    return failures();
+}